@@ -0,0 +1,78 @@
+#include <cstring>
+#include "alien_store.h"
+
+static size_t alien_store_padded_count(size_t count)
+{
+	return (count + ALIEN_STORE_BLOCK - 1) / ALIEN_STORE_BLOCK * ALIEN_STORE_BLOCK;
+}
+
+void alien_store_init(AlienStore* store, Arena* arena, size_t count)
+{
+	size_t num_words = (count + 63) / 64;
+	store->count = count;
+	store->x = arena_alloc_array<int16_t>(arena, count);
+	store->y = arena_alloc_array<int16_t>(arena, count);
+	store->type = arena_alloc_array<uint8_t>(arena, count);
+	// Padded to whole blocks so the countdown needs no scalar tail
+	store->death_counter = arena_alloc_array<uint8_t>(arena, alien_store_padded_count(count));
+	store->alive = arena_alloc_array<uint64_t>(arena, num_words);
+	store->generation = arena_alloc_array<uint32_t>(arena, count);
+	memset(store->x, 0, count * sizeof(int16_t));
+	memset(store->y, 0, count * sizeof(int16_t));
+	memset(store->type, 0, count);
+	memset(store->generation, 0, count * sizeof(uint32_t));
+	alien_store_reset(store);
+}
+
+void alien_store_reset(AlienStore* store)
+{
+	size_t count = store->count;
+	size_t num_words = (count + 63) / 64;
+	memset(store->death_counter, 0, alien_store_padded_count(count));
+	for(size_t i = 0; i < count; ++i)
+	{
+		++store->generation[i];
+	}
+	for(size_t w = 0; w < num_words; ++w)
+	{
+		store->alive[w] = ~(uint64_t)0;
+	}
+	// Bits past the last alien stay clear so that whole words can be counted
+	if(count % 64)
+	{
+		store->alive[num_words - 1] = ((uint64_t)1 << (count % 64)) - 1;
+	}
+}
+
+void alien_store_kill(AlienStore* store, size_t i, uint8_t death_frames)
+{
+	store->alive[i / 64] &= ~((uint64_t)1 << (i % 64));
+	store->death_counter[i] = death_frames;
+	++store->generation[i];
+}
+
+size_t alien_store_num_alive(const AlienStore& store)
+{
+	size_t num_alive = 0;
+	for(size_t w = 0; w < (store.count + 63) / 64; ++w)
+	{
+		num_alive += __builtin_popcountll(store.alive[w]);
+	}
+	return num_alive;
+}
+
+void alien_store_update_deaths(AlienStore* store)
+{
+	// Branchless and in fixed size blocks, so that it compiles to vector
+	// compares and subtracts even at -O2. The padding counters are always 0
+	uint8_t* death_counter = store->death_counter;
+	size_t count = alien_store_padded_count(store->count);
+	for(size_t i = 0; i < count; i += ALIEN_STORE_BLOCK)
+	{
+		uint8_t* block = death_counter + i;
+		for(size_t j = 0; j < ALIEN_STORE_BLOCK; ++j)
+		{
+			block[j] -= block[j] != 0;
+		}
+	}
+}
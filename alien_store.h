@@ -0,0 +1,68 @@
+#ifndef ALIEN_STORE_H
+#define ALIEN_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "pool.h"
+#include "arena.h"
+
+// Counters are processed in blocks of this many aliens
+#define ALIEN_STORE_BLOCK 32
+
+// All the aliens of a formation as parallel arrays, one entry per alien.
+// Passes that only need one or two fields stream through those arrays
+// alone, and the byte-sized counters are updated 16 to 64 at a time by
+// the auto-vectorized loops
+struct AlienStore
+{
+	size_t count;
+	// Position in pixels from the bottom left corner of window, where the
+	// formation was laid out (see AlienMarch for the offset of the block)
+	int16_t* x;
+	int16_t* y;
+	// AlienType, kept after the alien dies
+	uint8_t* type;
+	// Frames left to show the death sprite, 0 while alive and once it is gone
+	uint8_t* death_counter;
+	// Bit i is set while alien i is alive, 64 aliens per word
+	uint64_t* alive;
+	// Bumped when the alien dies, to tell stale handles apart
+	uint32_t* generation;
+};
+
+// Store for count aliens, all alive, at position 0,0 and of type 0.
+// The arrays are allocated from the arena and live as long as it does
+void alien_store_init(AlienStore* store, Arena* arena, size_t count);
+
+// Bring every alien back to life, with no death sprite showing.
+// Handles from before the reset stop resolving
+void alien_store_reset(AlienStore* store);
+
+inline bool alien_store_alive(const AlienStore& store, size_t i)
+{
+	return (store.alive[i / 64] >> (i % 64)) & 1;
+}
+
+// Handle to alien i, which resolves for as long as the alien is alive
+inline PoolHandle alien_store_handle(const AlienStore& store, size_t i)
+{
+	PoolHandle handle = {(uint32_t)i, store.generation[i]};
+	return handle;
+}
+
+// Index of the alien the handle refers to, or -1 if it died since
+inline ptrdiff_t alien_store_resolve(const AlienStore& store, PoolHandle handle)
+{
+	if(handle.index >= store.count || store.generation[handle.index] != handle.generation) return -1;
+	return handle.index;
+}
+
+// Mark the alien dead and show its death sprite for death_frames frames
+void alien_store_kill(AlienStore* store, size_t i, uint8_t death_frames);
+
+size_t alien_store_num_alive(const AlienStore& store);
+
+// Count down the death counters by one frame
+void alien_store_update_deaths(AlienStore* store);
+
+#endif
@@ -0,0 +1,26 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "alloc_counter.h"
+
+// Replaces the global operator new of the whole program, linking this file in
+// is enough. The array and nothrow forms of the standard library call these
+static std::atomic<size_t> num_allocs(0);
+
+size_t alloc_count()
+{
+	return num_allocs.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+	num_allocs.fetch_add(1, std::memory_order_relaxed);
+	void* memory = malloc(size? size: 1);
+	if(!memory) throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
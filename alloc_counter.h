@@ -0,0 +1,12 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstddef>
+
+// Calls to operator new (and new[]) made so far by every thread. The game
+// loop compares it from frame to frame: once warmed up, a frame should not
+// allocate at all, everything it needs comes from the arenas or from
+// containers that have already grown to their working size
+size_t alloc_count();
+
+#endif
@@ -0,0 +1,70 @@
+#include <cassert>
+#include "arena.h"
+
+void arena_init(Arena* arena, size_t block_size)
+{
+	arena->first = arena->current = NULL;
+	arena->block_size = block_size;
+	arena->used = 0;
+	arena->peak = 0;
+}
+
+void arena_free(Arena* arena)
+{
+	ArenaBlock* block = arena->first;
+	while(block)
+	{
+		ArenaBlock* next = block->next;
+		delete[] block->data;
+		delete block;
+		block = next;
+	}
+	arena->first = arena->current = NULL;
+	arena->used = 0;
+}
+
+// Offset of the first byte at or past used that is aligned to alignment
+static size_t align_up(const ArenaBlock* block, size_t alignment)
+{
+	uintptr_t address = (uintptr_t)(block->data + block->used);
+	return block->used + ((alignment - address % alignment) % alignment);
+}
+
+void* arena_alloc(Arena* arena, size_t size, size_t alignment)
+{
+	assert(alignment && (alignment & (alignment - 1)) == 0);
+	ArenaBlock* block = arena->current;
+	// Move on to the next block until the allocation fits, the blocks past
+	// the current one are only there from before the last reset
+	while(block && align_up(block, alignment) + size > block->size)
+	{
+		if(!block->next) break;
+		block = block->next;
+		block->used = 0;
+	}
+	if(!block || align_up(block, alignment) + size > block->size)
+	{
+		ArenaBlock* added = new ArenaBlock;
+		added->size = size + alignment > arena->block_size? size + alignment: arena->block_size;
+		added->used = 0;
+		added->data = new uint8_t[added->size];
+		added->next = NULL;
+		if(block) block->next = added;
+		else arena->first = added;
+		block = added;
+	}
+	arena->current = block;
+
+	size_t offset = align_up(block, alignment);
+	arena->used += offset + size - block->used;
+	if(arena->used > arena->peak) arena->peak = arena->used;
+	block->used = offset + size;
+	return block->data + offset;
+}
+
+void arena_reset(Arena* arena)
+{
+	arena->current = arena->first;
+	if(arena->current) arena->current->used = 0;
+	arena->used = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// One chunk of the memory of an arena, chained in the order they are used
+struct ArenaBlock
+{
+	ArenaBlock* next;
+	size_t size;
+	size_t used;
+	uint8_t* data;
+};
+
+// Linear allocator: allocations are carved one after the other out of large
+// blocks and are only released all at once, by a reset or by freeing the
+// arena. Blocks are kept across resets, so an arena that is reset every
+// frame stops touching the heap once it has grown to the largest frame.
+// One arena holds data living as long as a level, another the scratch
+// space of a frame
+struct Arena
+{
+	ArenaBlock* first;
+	ArenaBlock* current;
+	// Size of the blocks, larger allocations get a block of their own
+	size_t block_size;
+	// Bytes handed out since the last reset, and the most ever
+	size_t used;
+	size_t peak;
+};
+
+void arena_init(Arena* arena, size_t block_size = 64 * 1024);
+void arena_free(Arena* arena);
+
+// Uninitialized memory for size bytes, aligned to alignment (a power of two)
+void* arena_alloc(Arena* arena, size_t size, size_t alignment);
+
+// Make all the memory of the arena available again, without freeing it
+void arena_reset(Arena* arena);
+
+// Array of count default-initialized T, for types that need no destructor
+template<typename T>
+T* arena_alloc_array(Arena* arena, size_t count)
+{
+	T* items = (T*)arena_alloc(arena, count * sizeof(T), alignof(T));
+	for(size_t i = 0; i < count; ++i)
+	{
+		new(&items[i]) T;
+	}
+	return items;
+}
+
+#endif
@@ -0,0 +1,227 @@
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#if defined(__unix__) || defined(__APPLE__)
+#define ASSET_PACK_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#include "asset_pack.h"
+
+// Whether count items of size bytes at offset lie within the pack, aligned
+static bool pack_range(const AssetPack* pack, uint32_t offset, size_t count, size_t size)
+{
+	return offset % 4 == 0 && offset <= pack->size && count * size <= pack->size - offset;
+}
+
+void asset_pack_close(AssetPack* pack)
+{
+#ifdef ASSET_PACK_MMAP
+	if(pack->mapping) munmap(pack->mapping, pack->size);
+#else
+	delete[] (uint8_t*)pack->mapping;
+#endif
+	pack->mapping = NULL;
+}
+
+static bool asset_pack_fail(AssetPack* pack, const char* error)
+{
+	pack->error = error;
+	asset_pack_close(pack);
+	return false;
+}
+
+#ifdef ASSET_PACK_MMAP
+// Map the file read-only, so the pack is paged in as it is drawn from
+static bool asset_pack_map(AssetPack* pack, const char* path)
+{
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0) return asset_pack_fail(pack, "cannot open the file");
+	struct stat info;
+	if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(AssetPackHeader))
+	{
+		close(fd);
+		return asset_pack_fail(pack, "file too small");
+	}
+	pack->size = info.st_size;
+	void* mapping = mmap(NULL, pack->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapping == MAP_FAILED) return asset_pack_fail(pack, "cannot map the file");
+	pack->mapping = mapping;
+	return true;
+}
+#else
+// Without mmap the file is read into memory, which the pack owns instead
+static bool asset_pack_map(AssetPack* pack, const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if(!file) return asset_pack_fail(pack, "cannot open the file");
+	long size = fseek(file, 0, SEEK_END) == 0? ftell(file): -1;
+	if(size < (long)sizeof(AssetPackHeader) || fseek(file, 0, SEEK_SET) != 0)
+	{
+		fclose(file);
+		return asset_pack_fail(pack, "file too small");
+	}
+	pack->size = size;
+	// new[] storage is aligned for anything, as a mapping would be
+	pack->mapping = new uint8_t[pack->size];
+	bool read = fread(pack->mapping, 1, pack->size, file) == pack->size;
+	fclose(file);
+	if(!read) return asset_pack_fail(pack, "cannot read the file");
+	return true;
+}
+#endif
+
+bool asset_pack_open(AssetPack* pack, const char* path)
+{
+	pack->mapping = NULL;
+	pack->size = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return asset_pack_fail(pack, "asset packs are little-endian");
+#endif
+
+	if(!asset_pack_map(pack, path)) return false;
+
+	const uint8_t* base = (const uint8_t*)pack->mapping;
+	const AssetPackHeader& header = *(const AssetPackHeader*)base;
+	if(memcmp(header.magic, "SIAP", 4) != 0) return asset_pack_fail(pack, "not an asset pack");
+	if(header.version != ASSET_PACK_VERSION) return asset_pack_fail(pack, "unsupported version");
+	if(header.size != pack->size) return asset_pack_fail(pack, "truncated");
+	if(header.num_sprites != NUM_ASSET_SPRITES ||
+			!pack_range(pack, header.sprites_offset, NUM_ASSET_SPRITES, sizeof(AssetPackSprite)) ||
+			!pack_range(pack, header.animations_offset, 3, sizeof(AssetAnimation)) ||
+			!pack_range(pack, header.formation_offset, 1, sizeof(AssetFormation)))
+	{
+		return asset_pack_fail(pack, "bad table offsets");
+	}
+
+	// The sprites point to their rows in the mapping, only the small
+	// animation and formation tables are copied
+	Sprite sprites[NUM_ASSET_SPRITES];
+	const AssetPackSprite* records = (const AssetPackSprite*)(base + header.sprites_offset);
+	for(size_t i = 0; i < NUM_ASSET_SPRITES; ++i)
+	{
+		const AssetPackSprite& record = records[i];
+		// Every character draw_list_text knows needs a glyph
+		size_t frames = i == ASSET_SPRITE_TEXT? 65: 1;
+		if(record.width == 0 || record.width > SPRITE_MAX_WIDTH || record.height == 0 ||
+				record.frames != frames || !pack_range(pack, record.rows_offset, frames * record.height, sizeof(uint32_t)))
+		{
+			return asset_pack_fail(pack, "bad sprite");
+		}
+		sprites[i].width = record.width;
+		sprites[i].height = record.height;
+		sprites[i].data = NULL;
+		sprites[i].rows = (const uint32_t*)(base + record.rows_offset);
+	}
+
+	GameAssets& assets = pack->assets;
+	for(size_t i = 0; i < 6; ++i)
+	{
+		assets.alien_sprites[i] = sprites[ASSET_SPRITE_ALIEN_A0 + i];
+	}
+	assets.alien_death_sprite = sprites[ASSET_SPRITE_ALIEN_DEATH];
+	assets.player_sprite = sprites[ASSET_SPRITE_PLAYER];
+	assets.bullet_sprite = sprites[ASSET_SPRITE_BULLET];
+	assets.text_spritesheet = sprites[ASSET_SPRITE_TEXT];
+	// The digits of the font, starting at '0'
+	assets.number_spritesheet = sprites[ASSET_SPRITE_TEXT];
+	assets.number_spritesheet.rows += 16 * assets.number_spritesheet.height;
+	memcpy(assets.alien_animations, base + header.animations_offset, sizeof(assets.alien_animations));
+	memcpy(&assets.formation, base + header.formation_offset, sizeof(assets.formation));
+	pack->error = NULL;
+	return true;
+}
+
+#ifdef __linux__
+bool asset_watch_init(AssetWatch* watch, const char* path)
+{
+	watch->watching = false;
+	const char* slash = strrchr(path, '/');
+	const char* name = slash? slash + 1: path;
+	char directory[4096];
+	if(strlen(name) >= sizeof(watch->name) || (size_t)(name - path) >= sizeof(directory)) return false;
+	strcpy(watch->name, name);
+	if(slash)
+	{
+		memcpy(directory, path, slash - path);
+		directory[slash - path] = '\0';
+		if(slash == path) strcpy(directory, "/");
+	}
+	else
+	{
+		strcpy(directory, ".");
+	}
+
+	watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(watch->fd < 0) return false;
+	if(inotify_add_watch(watch->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		close(watch->fd);
+		watch->fd = -1;
+		return false;
+	}
+	watch->watching = true;
+	return true;
+}
+
+void asset_watch_free(AssetWatch* watch)
+{
+	if(watch->watching) close(watch->fd);
+	watch->watching = false;
+}
+
+bool asset_watch_changed(AssetWatch* watch)
+{
+	bool changed = false;
+	alignas(inotify_event) char events[4096];
+	ssize_t length;
+	while((length = read(watch->fd, events, sizeof(events))) > 0)
+	{
+		for(ssize_t offset = 0; offset < length;)
+		{
+			const inotify_event* event = (const inotify_event*)(events + offset);
+			if(event->len && strcmp(event->name, watch->name) == 0) changed = true;
+			offset += sizeof(inotify_event) + event->len;
+		}
+	}
+	return changed;
+}
+#else
+// What stat reports of the file, 0 while it does not exist
+static void asset_watch_stat(AssetWatch* watch)
+{
+	struct stat info;
+	if(stat(watch->path, &info) != 0) memset(&info, 0, sizeof(info));
+	watch->inode = info.st_ino;
+	watch->size = info.st_size;
+	watch->mtime = info.st_mtime;
+}
+
+bool asset_watch_init(AssetWatch* watch, const char* path)
+{
+	watch->watching = false;
+	if(strlen(path) >= sizeof(watch->path)) return false;
+	strcpy(watch->path, path);
+	asset_watch_stat(watch);
+	watch->watching = true;
+	return true;
+}
+
+void asset_watch_free(AssetWatch* watch)
+{
+	watch->watching = false;
+}
+
+bool asset_watch_changed(AssetWatch* watch)
+{
+	uint64_t inode = watch->inode, size = watch->size;
+	int64_t mtime = watch->mtime;
+	asset_watch_stat(watch);
+	return watch->inode != inode || watch->size != size || watch->mtime != mtime;
+}
+#endif
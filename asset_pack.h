@@ -0,0 +1,100 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include "assets.h"
+
+#define ASSET_PACK_VERSION 1
+
+// Sprites of a pack, in this order
+enum AssetSprite
+{
+	ASSET_SPRITE_ALIEN_A0,
+	ASSET_SPRITE_ALIEN_A1,
+	ASSET_SPRITE_ALIEN_B0,
+	ASSET_SPRITE_ALIEN_B1,
+	ASSET_SPRITE_ALIEN_C0,
+	ASSET_SPRITE_ALIEN_C1,
+	ASSET_SPRITE_ALIEN_DEATH,
+	ASSET_SPRITE_PLAYER,
+	ASSET_SPRITE_BULLET,
+	// The font, one glyph per frame from ' ' on
+	ASSET_SPRITE_TEXT,
+	NUM_ASSET_SPRITES
+};
+
+// Binary asset pack, built by tools/asset_packer from a text description and
+// mapped into memory as it is. Everything is little-endian and 4-byte
+// aligned, offsets are from the start of the file:
+//   AssetPackHeader
+//   AssetPackSprite[num_sprites] at sprites_offset
+//   AssetAnimation[3] at animations_offset
+//   AssetFormation at formation_offset
+//   row masks of the sprites, as drawn (see Sprite::rows)
+// A sprite of several frames, such as the font, has its frames one after
+// the other, height rows each
+struct AssetPackHeader
+{
+	// "SIAP"
+	char magic[4];
+	uint16_t version;
+	uint16_t num_sprites;
+	// Size of the whole file
+	uint32_t size;
+	uint32_t sprites_offset;
+	uint32_t animations_offset;
+	uint32_t formation_offset;
+};
+
+struct AssetPackSprite
+{
+	uint16_t width, height;
+	uint16_t frames;
+	uint16_t reserved;
+	uint32_t rows_offset;
+};
+
+// A pack mapped read-only, with the game assets pointing into it. Systems
+// without mmap get a copy of the file read into memory instead
+struct AssetPack
+{
+	void* mapping;
+	size_t size;
+	GameAssets assets;
+	// Why the last asset_pack_open failed
+	const char* error;
+};
+
+// Map the pack at path and check it. Returns false, with pack->error set, if
+// it cannot be read or is not a valid pack of this version
+bool asset_pack_open(AssetPack* pack, const char* path);
+void asset_pack_close(AssetPack* pack);
+
+// Reports when the file at a path is written or replaced. Linux uses
+// inotify on its directory, so that a file renamed over it counts too;
+// elsewhere the file is polled with stat
+struct AssetWatch
+{
+	bool watching;
+#ifdef __linux__
+	int fd;
+	// File name within the directory
+	char name[256];
+#else
+	char path[4096];
+	// As stat last reported them. A rename changes the inode, a write within
+	// the same second is only seen if it changes the size
+	uint64_t inode, size;
+	int64_t mtime;
+#endif
+};
+
+// Returns false, with watching false, if the file cannot be watched
+bool asset_watch_init(AssetWatch* watch, const char* path);
+void asset_watch_free(AssetWatch* watch);
+
+// Whether the file changed since the last call, without blocking
+bool asset_watch_changed(AssetWatch* watch);
+
+#endif
@@ -0,0 +1,242 @@
+#include "assets.h"
+
+// The sprites are defined as pixels, one byte per pixel and row by row from
+// the top, which the compiler packs into the row masks used for drawing.
+// Both end up in read-only data, nothing is built at startup
+
+// Row mask of row r of a bitmap width pixels wide, bit i being column i
+static constexpr uint32_t pack_row(const uint8_t* pixels, size_t width, size_t r, size_t i = 0)
+{
+	return i == width? 0: ((uint32_t)(pixels[r * width + i] != 0) << i) | pack_row(pixels, width, r, i + 1);
+}
+
+template<size_t... Rows> struct RowIndices {};
+template<size_t N, size_t... Rows> struct MakeRowIndices: MakeRowIndices<N - 1, N - 1, Rows...> {};
+template<size_t... Rows> struct MakeRowIndices<0, Rows...> { typedef RowIndices<Rows...> type; };
+
+template<size_t N>
+struct PackedRows
+{
+	uint32_t rows[N];
+};
+
+template<size_t N, size_t... Rows>
+static constexpr PackedRows<N> pack_rows(const uint8_t* pixels, size_t width, RowIndices<Rows...>)
+{
+	return PackedRows<N>{{pack_row(pixels, width, Rows)...}};
+}
+
+// Row masks of num_rows rows of pixels
+#define PACK_ROWS(pixels, width, num_rows) pack_rows<num_rows>(pixels, width, MakeRowIndices<num_rows>::type())
+
+
+static constexpr uint8_t alien_a0_pixels[] =
+{
+	0,0,0,1,1,0,0,0, // ...@@...
+	0,0,1,1,1,1,0,0, // ..@@@@..
+	0,1,1,1,1,1,1,0, // .@@@@@@.
+	1,1,0,1,1,0,1,1, // @@.@@.@@
+	1,1,1,1,1,1,1,1, // @@@@@@@@
+	0,1,0,1,1,0,1,0, // .@.@@.@.
+	1,0,0,0,0,0,0,1, // @......@
+	0,1,0,0,0,0,1,0  // .@....@.
+};
+static constexpr PackedRows<8> alien_a0_rows = PACK_ROWS(alien_a0_pixels, 8, 8);
+
+static constexpr uint8_t alien_a1_pixels[] =
+{
+	0,0,0,1,1,0,0,0, // ...@@...
+	0,0,1,1,1,1,0,0, // ..@@@@..
+	0,1,1,1,1,1,1,0, // .@@@@@@.
+	1,1,0,1,1,0,1,1, // @@.@@.@@
+	1,1,1,1,1,1,1,1, // @@@@@@@@
+	0,0,1,0,0,1,0,0, // ..@..@..
+	0,1,0,1,1,0,1,0, // .@.@@.@.
+	1,0,1,0,0,1,0,1  // @.@..@.@
+};
+static constexpr PackedRows<8> alien_a1_rows = PACK_ROWS(alien_a1_pixels, 8, 8);
+
+static constexpr uint8_t alien_b0_pixels[] =
+{
+	0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
+	0,0,0,1,0,0,0,1,0,0,0, // ...@...@...
+	0,0,1,1,1,1,1,1,1,0,0, // ..@@@@@@@..
+	0,1,1,0,1,1,1,0,1,1,0, // .@@.@@@.@@.
+	1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
+	1,0,1,1,1,1,1,1,1,0,1, // @.@@@@@@@.@
+	1,0,1,0,0,0,0,0,1,0,1, // @.@.....@.@
+	0,0,0,1,1,0,1,1,0,0,0  // ...@@.@@...
+};
+static constexpr PackedRows<8> alien_b0_rows = PACK_ROWS(alien_b0_pixels, 11, 8);
+
+static constexpr uint8_t alien_b1_pixels[] =
+{
+	0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
+	1,0,0,1,0,0,0,1,0,0,1, // @..@...@..@
+	1,0,1,1,1,1,1,1,1,0,1, // @.@@@@@@@.@
+	1,1,1,0,1,1,1,0,1,1,1, // @@@.@@@.@@@
+	1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
+	0,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@.
+	0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
+	0,1,0,0,0,0,0,0,0,1,0  // .@.......@.
+};
+static constexpr PackedRows<8> alien_b1_rows = PACK_ROWS(alien_b1_pixels, 11, 8);
+
+static constexpr uint8_t alien_c0_pixels[] =
+{
+	0,0,0,0,1,1,1,1,0,0,0,0, // ....@@@@....
+	0,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@.
+	1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
+	1,1,1,0,0,1,1,0,0,1,1,1, // @@@..@@..@@@
+	1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
+	0,0,0,1,1,0,0,1,1,0,0,0, // ...@@..@@...
+	0,0,1,1,0,1,1,0,1,1,0,0, // ..@@.@@.@@..
+	1,1,0,0,0,0,0,0,0,0,1,1  // @@........@@
+};
+static constexpr PackedRows<8> alien_c0_rows = PACK_ROWS(alien_c0_pixels, 12, 8);
+
+static constexpr uint8_t alien_c1_pixels[] =
+{
+	0,0,0,0,1,1,1,1,0,0,0,0, // ....@@@@....
+	0,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@.
+	1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
+	1,1,1,0,0,1,1,0,0,1,1,1, // @@@..@@..@@@
+	1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
+	0,0,1,1,1,0,0,1,1,1,0,0, // ..@@@..@@@..
+	0,1,1,0,0,1,1,0,0,1,1,0, // .@@..@@..@@.
+	0,0,1,1,0,0,0,0,1,1,0,0  // ..@@....@@..
+};
+static constexpr PackedRows<8> alien_c1_rows = PACK_ROWS(alien_c1_pixels, 12, 8);
+
+static constexpr uint8_t alien_death_pixels[] =
+{
+	0,1,0,0,1,0,0,0,1,0,0,1,0, // .@..@...@..@.
+	0,0,1,0,0,1,0,1,0,0,1,0,0, // ..@..@.@..@..
+	0,0,0,1,0,0,0,0,0,1,0,0,0, // ...@.....@...
+	1,1,0,0,0,0,0,0,0,0,0,1,1, // @@.........@@
+	0,0,0,1,0,0,0,0,0,1,0,0,0, // ...@.....@...
+	0,0,1,0,0,1,0,1,0,0,1,0,0, // ..@..@.@..@..
+	0,1,0,0,1,0,0,0,1,0,0,1,0  // .@..@...@..@.
+};
+static constexpr PackedRows<7> alien_death_rows = PACK_ROWS(alien_death_pixels, 13, 7);
+
+static constexpr uint8_t player_pixels[] =
+{
+	0,0,0,0,0,1,0,0,0,0,0, // .....@.....
+	0,0,0,0,1,1,1,0,0,0,0, // ....@@@....
+	0,0,0,0,1,1,1,0,0,0,0, // ....@@@....
+	0,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@.
+	1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
+	1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
+	1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
+};
+static constexpr PackedRows<7> player_rows = PACK_ROWS(player_pixels, 11, 7);
+
+// 65 5x7 characters starting from 'space' at 32 in ASCII to '`' ASCII 96
+static constexpr uint8_t text_pixels[] =
+{
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,1,0,0,
+	0,1,0,1,0,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,1,0,1,0,0,1,0,1,0,1,1,1,1,1,0,1,0,1,0,1,1,1,1,1,0,1,0,1,0,0,1,0,1,0,
+	0,0,1,0,0,0,1,1,1,0,1,0,1,0,0,0,1,1,1,0,0,0,1,0,1,0,1,1,1,0,0,0,1,0,0,
+	1,1,0,1,0,1,1,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,1,1,0,1,0,1,1,
+	0,1,1,0,0,1,0,0,1,0,1,0,0,1,0,0,1,1,0,0,1,0,0,1,0,1,0,0,0,1,0,1,1,1,1,
+	0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,
+	1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,
+	0,0,1,0,0,1,0,1,0,1,0,1,1,1,0,0,0,1,0,0,0,1,1,1,0,1,0,1,0,1,0,0,1,0,0,
+	0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,1,1,1,1,1,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,
+	0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,
+
+	0,1,1,1,0,1,0,0,0,1,1,0,0,1,1,1,0,1,0,1,1,1,0,0,1,1,0,0,0,1,0,1,1,1,0,
+	0,0,1,0,0,0,1,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,1,1,0,
+	0,1,1,1,0,1,0,0,0,1,0,0,0,0,1,0,0,1,1,0,0,1,0,0,0,1,0,0,0,0,1,1,1,1,1,
+	1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,1,0,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+	0,0,0,1,0,0,0,1,1,0,0,1,0,1,0,1,0,0,1,0,1,1,1,1,1,0,0,0,1,0,0,0,0,1,0,
+	1,1,1,1,1,1,0,0,0,0,1,1,1,1,0,0,0,0,0,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+	0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+	1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,
+	0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+	0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+
+	0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,
+	0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,
+	0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,
+	1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,
+	0,1,1,1,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,1,0,0,
+	0,1,1,1,0,1,0,0,0,1,1,0,1,0,1,1,1,0,1,1,1,0,1,0,0,1,0,0,0,1,0,1,1,1,0,
+
+	0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,1,1,0,0,0,1,1,0,0,0,1,
+	1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,
+	0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,1,1,1,0,
+	1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,
+	1,1,1,1,1,1,0,0,0,0,1,0,0,0,0,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,1,1,1,1,
+	1,1,1,1,1,1,0,0,0,0,1,0,0,0,0,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,
+	0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,0,1,1,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+	1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,1,1,1,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,
+	0,1,1,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,1,1,0,
+	0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+	1,0,0,0,1,1,0,0,1,0,1,0,1,0,0,1,1,0,0,0,1,0,1,0,0,1,0,0,1,0,1,0,0,0,1,
+	1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,1,1,1,1,
+	1,0,0,0,1,1,1,0,1,1,1,0,1,0,1,1,0,1,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,
+	1,0,0,0,1,1,0,0,0,1,1,1,0,0,1,1,0,1,0,1,1,0,0,1,1,1,0,0,0,1,1,0,0,0,1,
+	0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+	1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,
+	0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,1,0,1,1,0,0,1,1,0,1,1,1,1,
+	1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,1,0,0,1,0,0,1,0,1,0,0,0,1,
+	0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,0,1,1,1,0,1,0,0,0,1,0,0,0,0,1,0,1,1,1,0,
+	1,1,1,1,1,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,
+	1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+	1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,
+	1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,1,0,1,1,0,1,0,1,1,1,0,1,1,1,0,0,0,1,
+	1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,1,0,0,0,1,
+	1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,
+	1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,1,1,1,1,
+
+	0,0,0,1,1,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,1,
+	0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,
+	1,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,1,1,0,0,0,
+	0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,
+	0,0,1,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+static constexpr PackedRows<65 * 7> text_rows = PACK_ROWS(text_pixels, 5, 65 * 7);
+
+static constexpr uint8_t bullet_pixels[] =
+{
+	1, // @
+	1, // @
+	1  // @
+};
+static constexpr PackedRows<3> bullet_rows = PACK_ROWS(bullet_pixels, 1, 3);
+
+constexpr GameAssets game_assets =
+{
+	{
+		{8, 8, alien_a0_pixels, alien_a0_rows.rows},
+		{8, 8, alien_a1_pixels, alien_a1_rows.rows},
+		{11, 8, alien_b0_pixels, alien_b0_rows.rows},
+		{11, 8, alien_b1_pixels, alien_b1_rows.rows},
+		{12, 8, alien_c0_pixels, alien_c0_rows.rows},
+		{12, 8, alien_c1_pixels, alien_c1_rows.rows}
+	},
+	{13, 7, alien_death_pixels, alien_death_rows.rows},
+	{11, 7, player_pixels, player_rows.rows},
+	{1, 3, bullet_pixels, bullet_rows.rows},
+	{5, 7, text_pixels, text_rows.rows},
+	// The digits of the text spritesheet, starting at '0'
+	{5, 7, text_pixels + 16 * 35, text_rows.rows + 16 * 7},
+	// Two frames per alien type, 10 ticks each
+	{
+		{2, 10, {0, 1}},
+		{2, 10, {2, 3}},
+		{2, 10, {4, 5}}
+	},
+	// 11 by 5 aliens, the two bottom rows of type C, then B, with A on top
+	{11, 5, 20, 128, 16, 17, {3, 3, 2, 2, 1}}
+};
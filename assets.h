@@ -0,0 +1,50 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <cstdint>
+#include "buffer.h"
+
+// Frames an animation cycles through at most
+#define ASSET_MAX_ANIMATION_FRAMES 4
+// Rows of aliens a formation has at most
+#define ASSET_MAX_FORMATION_ROWS 16
+
+// Frames of an alien type's animation, as indices into alien_sprites,
+// each shown for frame_duration ticks
+struct AssetAnimation
+{
+	uint8_t num_frames;
+	uint8_t frame_duration;
+	uint8_t frames[ASSET_MAX_ANIMATION_FRAMES];
+};
+
+// Where the aliens start: columns by rows, the bottom left one at x,y and
+// the others dx and dy apart, with the alien type of each row from the bottom
+struct AssetFormation
+{
+	uint16_t columns, rows;
+	uint16_t x, y;
+	uint16_t dx, dy;
+	uint8_t row_types[ASSET_MAX_FORMATION_ROWS];
+};
+
+// All the sprites used by the game, how aliens are animated and laid out
+struct GameAssets
+{
+	Sprite alien_sprites[6];
+	Sprite alien_death_sprite;
+	Sprite player_sprite;
+	Sprite bullet_sprite;
+	Sprite text_spritesheet;
+	// The digits of text_spritesheet
+	Sprite number_spritesheet;
+	// One per alien type
+	AssetAnimation alien_animations[3];
+	AssetFormation formation;
+};
+
+// The game's sprites, built at compile time into read-only data. Used when
+// no asset pack is given, see asset_pack.h
+extern const GameAssets game_assets;
+
+#endif
@@ -0,0 +1,188 @@
+// Per-frame alien passes with the old array of structs layout against
+// the AlienStore parallel arrays, as the formation grows
+#include <cstdio>
+#include <cstdint>
+#include "../buffer.h"
+#include "../assets.h"
+#include "../draw_list.h"
+#include "../alien_store.h"
+#include "../timing.h"
+
+// The layout the game used before AlienStore
+struct OldAlien
+{
+	size_t x,y;
+	uint8_t type;
+};
+
+static const uint8_t OLD_ALIEN_DEAD = 0;
+
+struct OldAliens
+{
+	size_t count;
+	OldAlien* aliens;
+	uint8_t* death_counters;
+};
+
+static uint32_t random_state = 12345;
+static uint32_t random_next()
+{
+	random_state = random_state * 1664525u + 1013904223u;
+	return random_state >> 8;
+}
+
+static void old_update_deaths(OldAliens* old)
+{
+	for(size_t ai = 0; ai < old->count; ++ai)
+	{
+		const OldAlien& alien = old->aliens[ai];
+		if(alien.type == OLD_ALIEN_DEAD && old->death_counters[ai])
+		{
+			--old->death_counters[ai];
+		}
+	}
+}
+
+static void old_move(OldAliens* old, int dx)
+{
+	for(size_t ai = 0; ai < old->count; ++ai)
+	{
+		old->aliens[ai].x += dx;
+	}
+}
+
+static void old_draw(const OldAliens& old, const GameAssets& assets, DrawList* list)
+{
+	draw_list_reset(list, 0);
+	for(size_t ai = 0; ai < old.count; ++ai)
+	{
+		if(!old.death_counters[ai]) continue;
+
+		const OldAlien& alien = old.aliens[ai];
+		if(alien.type == OLD_ALIEN_DEAD)
+		{
+			draw_list_sprite(list, assets.alien_death_sprite, alien.x, alien.y, 1);
+		}
+		else
+		{
+			draw_list_sprite(list, assets.alien_sprites[2 * (alien.type - 1)], alien.x, alien.y, 1);
+		}
+	}
+}
+
+static void store_move(AlienStore* store, int dx)
+{
+	int16_t* x = store->x;
+	size_t count = store->count;
+	for(size_t ai = 0; ai < count; ++ai)
+	{
+		x[ai] += dx;
+	}
+}
+
+static void store_draw(const AlienStore& store, const GameAssets& assets, DrawList* list)
+{
+	// Local copies, as the pointers would otherwise be reloaded after every call
+	const int16_t* x = store.x;
+	const int16_t* y = store.y;
+	const uint8_t* type = store.type;
+	const uint8_t* death_counter = store.death_counter;
+	const uint64_t* alive = store.alive;
+
+	draw_list_reset(list, 0);
+	for(size_t ai = 0; ai < store.count; ++ai)
+	{
+		if((alive[ai / 64] >> (ai % 64)) & 1)
+		{
+			draw_list_sprite(list, assets.alien_sprites[2 * (type[ai] - 1)], x[ai], y[ai], 1);
+		}
+		else if(death_counter[ai])
+		{
+			draw_list_sprite(list, assets.alien_death_sprite, x[ai], y[ai], 1);
+		}
+	}
+}
+
+// Repeat pass until the measurement is long enough, returns ns per alien
+template<typename Pass>
+static double time_pass(size_t num_aliens, Pass pass)
+{
+	size_t passes = 0;
+	uint64_t start = time_ns();
+	uint64_t elapsed;
+	do
+	{
+		pass(passes);
+		++passes;
+		elapsed = time_ns() - start;
+	}
+	while(elapsed < 50000000);
+	return (double)elapsed / passes / num_aliens;
+}
+
+int main()
+{
+	const GameAssets& assets = game_assets;
+	DrawList list;
+	draw_list_init(&list);
+
+	const size_t alien_counts[] = {55, 550, 5500, 55000, 100000};
+
+	printf("%8s %12s %12s %12s %12s %12s %12s\n", "aliens",
+			"aos deaths", "soa deaths", "aos move", "soa move", "aos draw", "soa draw");
+	printf("%8s %12s %12s %12s %12s %12s %12s\n", "",
+			"ns/alien", "ns/alien", "ns/alien", "ns/alien", "ns/alien", "ns/alien");
+	for(size_t c = 0; c < sizeof(alien_counts) / sizeof(alien_counts[0]); ++c)
+	{
+		size_t num_aliens = alien_counts[c];
+
+		OldAliens old;
+		old.count = num_aliens;
+		old.aliens = new OldAlien[num_aliens];
+		old.death_counters = new uint8_t[num_aliens];
+		Arena arena;
+		arena_init(&arena);
+		AlienStore store;
+		alien_store_init(&store, &arena, num_aliens);
+
+		// Formation of 11 columns, a third of the aliens dead and
+		// some of those still showing their death sprite
+		for(size_t ai = 0; ai < num_aliens; ++ai)
+		{
+			uint8_t type = ai % 3 + 1;
+			size_t x = 16 * (ai % 11) + 20;
+			size_t y = 17 * (ai / 11) % 30000;
+			bool dead = random_next() % 3 == 0;
+			uint8_t death_frames = dead? random_next() % 11: 0;
+
+			old.aliens[ai].x = x;
+			old.aliens[ai].y = y;
+			old.aliens[ai].type = dead? OLD_ALIEN_DEAD: type;
+			old.death_counters[ai] = dead? death_frames: 10;
+
+			store.x[ai] = x;
+			store.y[ai] = y;
+			store.type[ai] = type;
+			if(dead) alien_store_kill(&store, ai, death_frames);
+		}
+
+		// Counters that reach 0 stay there, so most of the countdown
+		// passes see the steady state of a long running game
+		double old_deaths_ns = time_pass(num_aliens, [&](size_t) { old_update_deaths(&old); });
+		double store_deaths_ns = time_pass(num_aliens, [&](size_t) { alien_store_update_deaths(&store); });
+		double old_move_ns = time_pass(num_aliens, [&](size_t pass) { old_move(&old, pass % 2? -2: 2); });
+		double store_move_ns = time_pass(num_aliens, [&](size_t pass) { store_move(&store, pass % 2? -2: 2); });
+		double old_draw_ns = time_pass(num_aliens, [&](size_t) { old_draw(old, assets, &list); });
+		double store_draw_ns = time_pass(num_aliens, [&](size_t) { store_draw(store, assets, &list); });
+
+		printf("%8lu %12.2f %12.2f %12.2f %12.2f %12.2f %12.2f\n", num_aliens,
+				old_deaths_ns, store_deaths_ns, old_move_ns, store_move_ns, old_draw_ns, store_draw_ns);
+
+		delete[] old.aliens;
+		delete[] old.death_counters;
+		arena_free(&arena);
+	}
+
+	draw_list_free(&list);
+	return 0;
+}
@@ -0,0 +1,157 @@
+// Bullet vs alien collision cost as the number of entities grows:
+// the spatial grid broad phase against testing every bullet against every alien,
+// and the cost of the pixel-accurate narrow phase on top of the bounding boxes
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include "../buffer.h"
+#include "../assets.h"
+#include "../spatial_grid.h"
+#include "../timing.h"
+
+struct BenchAlien
+{
+	size_t x, y;
+	const Sprite* sprite;
+};
+
+static uint32_t random_state = 12345;
+static uint32_t random_next()
+{
+	random_state = random_state * 1664525u + 1013904223u;
+	return random_state >> 8;
+}
+
+typedef bool (*OverlapCheck)(const Sprite&, size_t, size_t, const Sprite&, size_t, size_t);
+
+// Run the grid broad phase with the given exact test for every bullet,
+// repeated until the measurement is long enough. Returns ns per bullet
+static double grid_pass(const SpatialGrid& grid, const BenchAlien* aliens,
+		const size_t* bullet_x, const size_t* bullet_y, size_t num_bullets,
+		const Sprite& bullet_sprite, OverlapCheck check, size_t* hits)
+{
+	size_t passes = 0;
+	uint64_t start = time_ns();
+	uint64_t elapsed;
+	do
+	{
+		*hits = 0;
+		for(size_t bi = 0; bi < num_bullets; ++bi)
+		{
+			Rect area = {bullet_x[bi], bullet_y[bi], bullet_x[bi] + bullet_sprite.width, bullet_y[bi] + bullet_sprite.height};
+			spatial_grid_query(grid, area, [&](size_t ai)
+			{
+				if(check(bullet_sprite, bullet_x[bi], bullet_y[bi],
+							*aliens[ai].sprite, aliens[ai].x, aliens[ai].y)) ++*hits;
+			});
+		}
+		++passes;
+		elapsed = time_ns() - start;
+	}
+	while(elapsed < 50000000);
+	return (double)elapsed / passes / num_bullets;
+}
+
+int main()
+{
+	const GameAssets& assets = game_assets;
+	const Sprite* sprites[3] = {&assets.alien_sprites[0], &assets.alien_sprites[2], &assets.alien_sprites[4]};
+	const Sprite& bullet_sprite = assets.bullet_sprite;
+
+	// Checks of the brute force pass above this are skipped
+	const double max_brute_pairs = 2e8;
+	const size_t alien_counts[] = {55, 550, 5500, 55000};
+
+	printf("%8s %8s %14s %14s %14s %14s %12s\n",
+			"aliens", "bullets", "grid ns/blt", "pixel ns/blt", "brute ns/blt", "move ns/alien", "hits");
+	for(size_t c = 0; c < sizeof(alien_counts) / sizeof(alien_counts[0]); ++c)
+	{
+		size_t num_aliens = alien_counts[c];
+		size_t num_bullets = num_aliens / 4 + 1;
+
+		// Formation laid out like the game's, 16 by 17 pixels per alien
+		size_t columns = (size_t)ceil(sqrt((double)num_aliens * 2));
+		size_t width = 16 * columns + 40;
+		size_t height = 17 * (num_aliens / columns + 1) + 40;
+
+		BenchAlien* aliens = new BenchAlien[num_aliens];
+		Arena arena;
+		arena_init(&arena);
+		SpatialGrid grid;
+		spatial_grid_init(&grid, &arena, num_aliens, width, height, 16, 16);
+		for(size_t i = 0; i < num_aliens; ++i)
+		{
+			aliens[i].sprite = sprites[i % 3];
+			aliens[i].x = 16 * (i % columns) + 20;
+			aliens[i].y = 17 * (i / columns) + 20;
+			spatial_grid_insert(&grid, i, aliens[i].x, aliens[i].y);
+		}
+
+		size_t* bullet_x = new size_t[num_bullets];
+		size_t* bullet_y = new size_t[num_bullets];
+		for(size_t i = 0; i < num_bullets; ++i)
+		{
+			bullet_x[i] = random_next() % width;
+			bullet_y[i] = random_next() % height;
+		}
+
+		size_t grid_hits, pixel_hits;
+		double grid_ns = grid_pass(grid, aliens, bullet_x, bullet_y, num_bullets,
+				bullet_sprite, sprite_overlap_check, &grid_hits);
+		double pixel_ns = grid_pass(grid, aliens, bullet_x, bullet_y, num_bullets,
+				bullet_sprite, sprite_pixel_overlap_check, &pixel_hits);
+
+		double brute_ns = -1;
+		size_t brute_hits = 0;
+		if((double)num_aliens * num_bullets <= max_brute_pairs)
+		{
+			uint64_t start = time_ns();
+			for(size_t bi = 0; bi < num_bullets; ++bi)
+			{
+				for(size_t ai = 0; ai < num_aliens; ++ai)
+				{
+					if(sprite_overlap_check(bullet_sprite, bullet_x[bi], bullet_y[bi],
+								*aliens[ai].sprite, aliens[ai].x, aliens[ai].y)) ++brute_hits;
+				}
+			}
+			brute_ns = (double)(time_ns() - start) / num_bullets;
+		}
+
+		// Incremental update: the whole formation steps 2 pixels sideways and back
+		size_t passes = 0;
+		uint64_t elapsed;
+		uint64_t start = time_ns();
+		do
+		{
+			size_t dx = passes % 2? 0: 2;
+			for(size_t ai = 0; ai < num_aliens; ++ai)
+			{
+				spatial_grid_move(&grid, ai, aliens[ai].x + dx, aliens[ai].y);
+			}
+			++passes;
+			elapsed = time_ns() - start;
+		}
+		while(elapsed < 50000000);
+		double move_ns = (double)elapsed / passes / num_aliens;
+
+		if(brute_ns >= 0)
+		{
+			printf("%8lu %8lu %14.1f %14.1f %14.1f %14.1f %5lu/%lu/%lu\n",
+					num_aliens, num_bullets, grid_ns, pixel_ns, brute_ns, move_ns,
+					grid_hits, pixel_hits, brute_hits);
+		}
+		else
+		{
+			printf("%8lu %8lu %14.1f %14.1f %14s %14.1f %5lu/%lu/-\n",
+					num_aliens, num_bullets, grid_ns, pixel_ns, "-", move_ns,
+					grid_hits, pixel_hits);
+		}
+
+		arena_free(&arena);
+		delete[] aliens;
+		delete[] bullet_x;
+		delete[] bullet_y;
+	}
+
+	return 0;
+}
@@ -0,0 +1,80 @@
+// Simulated frames per second of EnvBatch with random actions, for
+// batches of games stepped on 1 thread up to the number of hardware threads
+#include <cstdio>
+#include <cstdint>
+#include "../assets.h"
+#include "../env_batch.h"
+#include "../thread_pool.h"
+#include "../timing.h"
+
+// Episode length. Runs are whole episodes, as a game slows down when
+// bullets pile up and speeds up when aliens die
+#define EPISODE_STEPS 500
+
+// Random action sets are generated up front and cycled through, so that
+// the measurement is of the games and not of the random number generator
+#define NUM_ACTION_SETS 64
+
+static uint32_t random_state = 12345;
+static uint32_t random_next()
+{
+	random_state = random_state * 1664525u + 1013904223u;
+	return random_state >> 8;
+}
+
+int main()
+{
+	const GameAssets& assets = game_assets;
+
+	const size_t env_counts[] = {64, 1024, 8192};
+	size_t max_threads = thread_pool_hardware_threads();
+	if(max_threads < 8) max_threads = 8;
+
+	printf("Hardware threads: %lu\n", thread_pool_hardware_threads());
+	printf("%8s %8s %14s %10s %10s %10s\n", "envs", "threads", "frames/sec", "speedup", "episodes", "steals");
+	for(size_t c = 0; c < sizeof(env_counts) / sizeof(env_counts[0]); ++c)
+	{
+		size_t num_envs = env_counts[c];
+		GameInput* actions = new GameInput[NUM_ACTION_SETS * num_envs];
+		for(size_t i = 0; i < NUM_ACTION_SETS * num_envs; ++i)
+		{
+			uint32_t r = random_next();
+			actions[i].move_dir = (int)(r % 3) - 1;
+			actions[i].fire_pressed = (r >> 2) % 4 == 0;
+		}
+
+		double single_rate = 0;
+		for(size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+		{
+			ThreadPool pool;
+			thread_pool_init(&pool, num_threads);
+			EnvBatch batch;
+			env_batch_init(&batch, &pool, &assets, num_envs, EPISODE_STEPS);
+
+			size_t step = 0;
+			uint64_t start = time_ns();
+			uint64_t elapsed;
+			do
+			{
+				for(size_t i = 0; i < EPISODE_STEPS; ++i)
+				{
+					env_batch_step(&batch, actions + (step % NUM_ACTION_SETS) * num_envs);
+					++step;
+				}
+				elapsed = time_ns() - start;
+			}
+			while(elapsed < 300000000);
+
+			double rate = batch.total_steps * 1e9 / elapsed;
+			if(num_threads == 1) single_rate = rate;
+			printf("%8lu %8lu %14.0f %10.2f %10lu %10lu\n", num_envs, num_threads, rate,
+					rate / single_rate, batch.total_episodes, (size_t)pool.steals);
+
+			env_batch_free(&batch);
+			thread_pool_free(&pool);
+		}
+		delete[] actions;
+	}
+
+	return 0;
+}
@@ -0,0 +1,122 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+// Timing harness for the benchmarks, self-contained so that it builds
+// without fetching anything. An operation is first run in batches of
+// growing size until a batch lasts BENCH_BATCH_NS, then BENCH_SAMPLES
+// batches of that size are timed. The median batch gives the reported time
+// per call, the fastest one the best case. Results are printed as a table
+// and, with --json FILE, also written as JSON for scripts comparing runs
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include "../timing.h"
+
+#define BENCH_BATCH_NS 2000000
+#define BENCH_SAMPLES 9
+
+struct BenchStats
+{
+	// Time per call
+	double median_ns;
+	double min_ns;
+	// Calls per timed batch
+	size_t batch;
+};
+
+// Make the compiler assume value is used, so computing it is not optimized away
+template<typename T>
+inline void bench_keep(const T& value)
+{
+	asm volatile("" : : "r"(&value) : "memory");
+}
+
+template<typename Operation>
+BenchStats bench_measure(Operation operation)
+{
+	BenchStats stats;
+	size_t batch = 1;
+	for(;;)
+	{
+		uint64_t start = time_ns();
+		for(size_t i = 0; i < batch; ++i) operation();
+		if(time_ns() - start >= BENCH_BATCH_NS) break;
+		batch *= 2;
+	}
+
+	double samples[BENCH_SAMPLES];
+	for(size_t s = 0; s < BENCH_SAMPLES; ++s)
+	{
+		uint64_t start = time_ns();
+		for(size_t i = 0; i < batch; ++i) operation();
+		samples[s] = (double)(time_ns() - start) / batch;
+	}
+	std::sort(samples, samples + BENCH_SAMPLES);
+	stats.median_ns = samples[BENCH_SAMPLES / 2];
+	stats.min_ns = samples[0];
+	stats.batch = batch;
+	return stats;
+}
+
+// Results of one benchmark program
+struct BenchReport
+{
+	const char* suite;
+	FILE* json;
+	size_t num_results;
+};
+
+// Takes --json FILE from the command line. Returns false on an unknown argument
+inline bool bench_report_init(BenchReport* report, const char* suite, int argc, char* argv[])
+{
+	report->suite = suite;
+	report->json = NULL;
+	report->num_results = 0;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			report->json = fopen(argv[++i], "w");
+			if(!report->json)
+			{
+				fprintf(stderr, "Cannot write %s.\n", argv[i]);
+				return false;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--json FILE]\n", argv[0]);
+			return false;
+		}
+	}
+	if(report->json) fprintf(report->json, "{\"suite\":\"%s\",\"results\":[", suite);
+	printf("%-40s %12s %12s %14s\n", "benchmark", "median ns", "min ns", "items/s");
+	return true;
+}
+
+// Record a result. name identifies the case, e.g. "draw_sprite/alien/inside".
+// items is the work done per call (pixels, pairs, glyphs...) for the rate
+inline void bench_report_add(BenchReport* report, const char* name, const BenchStats& stats, double items = 1)
+{
+	double rate = items * 1e9 / stats.median_ns;
+	printf("%-40s %12.2f %12.2f %14.4g\n", name, stats.median_ns, stats.min_ns, rate);
+	if(report->json)
+	{
+		fprintf(report->json, "%s\n{\"name\":\"%s\",\"median_ns\":%.3f,\"min_ns\":%.3f,"
+				"\"items_per_call\":%.0f,\"items_per_second\":%.6g,\"batch\":%lu}",
+				report->num_results? ",": "", name, stats.median_ns, stats.min_ns, items, rate, stats.batch);
+	}
+	++report->num_results;
+}
+
+inline void bench_report_finish(BenchReport* report)
+{
+	if(!report->json) return;
+	fprintf(report->json, "\n]}\n");
+	fclose(report->json);
+	report->json = NULL;
+}
+
+#endif
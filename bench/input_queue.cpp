@@ -0,0 +1,112 @@
+// Cost of the input queue on one thread, and the latency of handing events
+// from a producer thread to a consumer polling like the simulation does.
+// Also checks that presses arriving within one tick all turn into shots
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include "../input_queue.h"
+#include "../timing.h"
+#include "harness.h"
+
+static void bench_push_pop(BenchReport* report)
+{
+	InputQueue queue;
+	input_queue_init(&queue);
+	InputEvent event = {0, INPUT_KEY_FIRE, true};
+	BenchStats stats = bench_measure([&]
+	{
+		++event.time_ns;
+		input_queue_push(&queue, event);
+		const InputEvent* front = input_queue_peek(&queue);
+		bench_keep(front->time_ns);
+		input_queue_pop(&queue);
+	});
+	bench_report_add(report, "input_queue/push_pop", stats);
+}
+
+// The producer stamps an event every interval_ns, the consumer polls and
+// yields in between; the delay is from the stamp to the pop
+static void bench_handoff(uint64_t interval_ns, size_t num_events)
+{
+	InputQueue queue;
+	input_queue_init(&queue);
+	uint64_t* delays = new uint64_t[num_events];
+	size_t dropped = 0;
+
+	std::thread producer([&]
+	{
+		uint64_t next = time_ns();
+		for(size_t i = 0; i < num_events; ++i)
+		{
+			next += interval_ns;
+			while(time_ns() < next) std::this_thread::yield();
+			InputEvent event = {time_ns(), INPUT_KEY_FIRE, (i % 2) == 0};
+			while(!input_queue_push(&queue, event))
+			{
+				++dropped;
+				std::this_thread::yield();
+			}
+		}
+	});
+	for(size_t received = 0; received < num_events;)
+	{
+		const InputEvent* event = input_queue_peek(&queue);
+		if(!event)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		delays[received++] = time_ns() - event->time_ns;
+		input_queue_pop(&queue);
+	}
+	producer.join();
+
+	std::sort(delays, delays + num_events);
+	double sum = 0;
+	for(size_t i = 0; i < num_events; ++i) sum += delays[i];
+	printf("handoff every %6.1f us: %lu events, %.2f us mean, %.2f us p50, %.2f us p99, %.2f us max, %lu full\n",
+			interval_ns / 1e3, num_events, sum / num_events / 1e3, delays[num_events / 2] / 1e3,
+			delays[num_events * 99 / 100] / 1e3, delays[num_events - 1] / 1e3, dropped);
+	delete[] delays;
+}
+
+// Presses and releases stamped within one tick fire once per tick after it
+static bool check_presses_kept()
+{
+	InputQueue queue;
+	input_queue_init(&queue);
+	InputState state;
+	input_state_init(&state);
+	InputLatency latency = {};
+	const size_t presses = 5;
+	for(size_t i = 0; i < presses; ++i)
+	{
+		InputEvent press = {10 * i, INPUT_KEY_FIRE, true};
+		InputEvent release = {10 * i + 5, INPUT_KEY_FIRE, false};
+		input_queue_push(&queue, press);
+		input_queue_push(&queue, release);
+	}
+	size_t shots = 0;
+	for(size_t tick = 0; tick < 2 * presses; ++tick)
+	{
+		shots += input_state_tick(&state, &queue, 1000 * (tick + 1), 1000 * (tick + 1), &latency).fire_pressed;
+	}
+	printf("%lu presses within one tick: %lu shots\n", presses, shots);
+	return shots == presses;
+}
+
+int main(int argc, char* argv[])
+{
+	BenchReport report;
+	if(!bench_report_init(&report, "input_queue", argc, argv)) return 1;
+
+	bench_push_pop(&report);
+	bench_report_finish(&report);
+
+	bench_handoff(1000000, 500);
+	bench_handoff(100000, 5000);
+	bench_handoff(10000, 20000);
+
+	return check_presses_kept()? 0: 1;
+}
@@ -0,0 +1,127 @@
+// Cost of marching the alien formation as it grows to thousands of aliens:
+// a simulation tick with the edges kept by the per-column and per-row alive
+// counts, against finding the edges by going through the aliens as a tick
+// would have to without them. Also checks that the counts kept as aliens are
+// shot match a recount from scratch
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include "../arena.h"
+#include "../assets.h"
+#include "../game.h"
+#include "harness.h"
+
+// Game with a formation of columns by rows, on a screen just large enough
+static void march_game_init(Game* game, Arena* arena, GameAssets* assets, size_t columns, size_t rows)
+{
+	*assets = game_assets;
+	AssetFormation& formation = assets->formation;
+	formation.columns = columns;
+	formation.rows = rows;
+	for(size_t yi = 0; yi < rows; ++yi)
+	{
+		formation.row_types[yi] = yi % 3 + 1;
+	}
+	size_t width = formation.x + columns * formation.dx + 2 * formation.x;
+	size_t height = formation.y + rows * formation.dy + 32;
+	game_init(game, arena, assets, width, height);
+}
+
+// Left, right and bottom of the aliens alive, the way a tick would find them
+// without the counts
+static void march_scan_edges(const Game& game, int32_t* left, int32_t* right, int32_t* bottom)
+{
+	const AlienStore& aliens = game.aliens;
+	*left = *bottom = INT32_MAX;
+	*right = INT32_MIN;
+	for(size_t ai = 0; ai < aliens.count; ++ai)
+	{
+		if(!alien_store_alive(aliens, ai)) continue;
+		if(aliens.x[ai] < *left) *left = aliens.x[ai];
+		if(aliens.x[ai] > *right) *right = aliens.x[ai];
+		if(aliens.y[ai] < *bottom) *bottom = aliens.y[ai];
+	}
+}
+
+static void bench_march(BenchReport* report, size_t columns, size_t rows)
+{
+	Arena arena;
+	arena_init(&arena);
+	GameAssets assets;
+	Game game;
+	march_game_init(&game, &arena, &assets, columns, rows);
+	size_t count = columns * rows;
+	GameInput input = {0, false};
+
+	char name[64];
+	BenchStats stats = bench_measure([&]
+	{
+		game_simulate(&game, input);
+		bench_keep(game.march.x);
+	});
+	snprintf(name, sizeof(name), "march/tick/%lu", count);
+	bench_report_add(report, name, stats, count);
+
+	stats = bench_measure([&]
+	{
+		int32_t left, right, bottom;
+		march_scan_edges(game, &left, &right, &bottom);
+		bench_keep(left);
+		bench_keep(right);
+		bench_keep(bottom);
+	});
+	snprintf(name, sizeof(name), "march/scan_edges/%lu", count);
+	bench_report_add(report, name, stats, count);
+
+	game_free(&game);
+	arena_free(&arena);
+}
+
+// Play with the player sweeping under the formation and firing, and recount
+// the aliens every tick. Returns false if the kept counts ever differ
+static bool check_counts_kept()
+{
+	Arena arena;
+	arena_init(&arena);
+	GameAssets assets;
+	Game game;
+	march_game_init(&game, &arena, &assets, 40, 8);
+	bool kept = true;
+	size_t ticks = 0;
+	for(; ticks < 100000 && game.march.num_alive; ++ticks)
+	{
+		GameInput input;
+		input.move_dir = ((ticks / game.width) % 2)? 1: -1;
+		input.fire_pressed = (ticks % 6) == 0;
+		game_simulate(&game, input);
+
+		AlienMarch kept_march = game.march;
+		game_recount_aliens(&game);
+		const AlienMarch& march = game.march;
+		if(march.num_alive != kept_march.num_alive || (march.num_alive &&
+				(march.left != kept_march.left || march.right != kept_march.right || march.bottom != kept_march.bottom)))
+		{
+			kept = false;
+			break;
+		}
+	}
+	printf("%lu ticks, %lu of %lu aliens shot, formation %d,%d from its layout: counts %s\n",
+			ticks, game.aliens.count - game.march.num_alive, game.aliens.count, game.march.x, game.march.y,
+			kept? "kept": "differ");
+	game_free(&game);
+	arena_free(&arena);
+	return kept;
+}
+
+int main(int argc, char* argv[])
+{
+	BenchReport report;
+	if(!bench_report_init(&report, "march", argc, argv)) return 1;
+
+	bench_march(&report, 11, 5);
+	bench_march(&report, 64, 16);
+	bench_march(&report, 625, 16);
+	bench_report_finish(&report);
+
+	return check_counts_kept()? 0: 1;
+}
@@ -0,0 +1,287 @@
+// Rendering and collision primitives one by one: clear and sprite drawing
+// with every supported instruction set, across sprite sizes and clip cases,
+// into 32-bit and palette-indexed buffers, text, numbers, colors and the
+// overlap checks for growing entity counts
+#include <cstdio>
+#include <cstdint>
+#include "../buffer.h"
+#include "../simd.h"
+#include "../assets.h"
+#include "../draw_list.h"
+#include "../text_cache.h"
+#include "harness.h"
+
+static uint32_t random_state = 12345;
+static uint32_t random_next()
+{
+	random_state = random_state * 1664525u + 1013904223u;
+	return random_state >> 8;
+}
+
+static const char* const kernel_names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+static void bench_clear(BenchReport* report)
+{
+	const size_t sizes[][2] = {{224, 256}, {640, 480}, {1920, 1080}, {3840, 2160}};
+	for(size_t k = 0; k < sizeof(kernel_names) / sizeof(kernel_names[0]); ++k)
+	{
+		if(!simd_select(kernel_names[k])) continue;
+		for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+		{
+			Buffer buffer;
+			buffer.width = sizes[s][0];
+			buffer.height = sizes[s][1];
+			buffer.format = PIXEL_RGBA;
+			buffer.data = new uint32_t[buffer.width * buffer.height];
+			buffer.indices = NULL;
+			uint32_t color = 0;
+			BenchStats stats = bench_measure([&]
+			{
+				buffer_clear(&buffer, ++color);
+				bench_keep(buffer.data[0]);
+			});
+			char name[64];
+			snprintf(name, sizeof(name), "clear/%s/%lux%lu", kernel_names[k], buffer.width, buffer.height);
+			bench_report_add(report, name, stats, buffer.width * buffer.height);
+			delete[] buffer.data;
+		}
+	}
+	raster_kernels = simd_detect();
+
+	// Indexed buffers are cleared with memset whatever the instruction set
+	for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+	{
+		Buffer buffer;
+		buffer.width = sizes[s][0];
+		buffer.height = sizes[s][1];
+		buffer.format = PIXEL_INDEXED;
+		buffer.data = NULL;
+		buffer.indices = new uint8_t[buffer.width * buffer.height];
+		uint32_t color = 0;
+		BenchStats stats = bench_measure([&]
+		{
+			buffer_clear(&buffer, ++color & 0xff);
+			bench_keep(buffer.indices[0]);
+		});
+		char name[64];
+		snprintf(name, sizeof(name), "clear/indexed/%lux%lu", buffer.width, buffer.height);
+		bench_report_add(report, name, stats, buffer.width * buffer.height);
+		delete[] buffer.indices;
+	}
+}
+
+static void bench_draw_sprite(BenchReport* report, const GameAssets& assets)
+{
+	// 32x32 with every pixel on, the widest a row mask holds
+	uint32_t block_rows[32];
+	for(size_t r = 0; r < 32; ++r) block_rows[r] = 0xffffffffu;
+	Sprite block;
+	block.width = 32;
+	block.height = 32;
+	block.data = NULL;
+	block.rows = block_rows;
+
+	struct { const char* name; const Sprite* sprite; } sprites[] = {
+		{"bullet", &assets.bullet_sprite},
+		{"alien", &assets.alien_sprites[4]},
+		{"player", &assets.player_sprite},
+		{"block32", &block}
+	};
+
+	Buffer buffers[2];
+	const char* format_names[] = {"", "indexed-"};
+	for(size_t f = 0; f < 2; ++f)
+	{
+		Buffer& buffer = buffers[f];
+		buffer.width = 224;
+		buffer.height = 256;
+		buffer.format = f? PIXEL_INDEXED: PIXEL_RGBA;
+		buffer.data = f? NULL: new uint32_t[buffer.width * buffer.height];
+		buffer.indices = f? new uint8_t[buffer.width * buffer.height]: NULL;
+		buffer_clear(&buffer, 0);
+	}
+
+	for(size_t k = 0; k < sizeof(kernel_names) / sizeof(kernel_names[0]); ++k)
+	{
+		if(!simd_select(kernel_names[k])) continue;
+		for(size_t f = 0; f < 2; ++f)
+		{
+			for(size_t s = 0; s < sizeof(sprites) / sizeof(sprites[0]); ++s)
+			{
+				Buffer& buffer = buffers[f];
+				const Sprite& sprite = *sprites[s].sprite;
+				// Fully inside, cut by the right and top edges, fully outside
+				struct { const char* name; size_t x, y; } cases[] = {
+					{"inside", 100, 100},
+					{"right", buffer.width - sprite.width / 2 - 1, 100},
+					{"top", 100, buffer.height - sprite.height / 2 - 1},
+					{"outside", buffer.width + 10, 100}
+				};
+				for(size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c)
+				{
+					uint32_t color = 0;
+					BenchStats stats = bench_measure([&]
+					{
+						buffer_draw_sprite(&buffer, sprite, cases[c].x, cases[c].y, f? ++color & 0xff: ++color);
+						bench_keep(f? buffer.indices[0]: buffer.data[0]);
+					});
+					char name[64];
+					snprintf(name, sizeof(name), "draw_sprite/%s%s/%s/%s", format_names[f], kernel_names[k],
+							sprites[s].name, cases[c].name);
+					bench_report_add(report, name, stats);
+				}
+			}
+		}
+	}
+	raster_kernels = simd_detect();
+
+	delete[] buffers[0].data;
+	delete[] buffers[1].indices;
+}
+
+static void bench_text(BenchReport* report, const GameAssets& assets)
+{
+	Buffer buffer;
+	buffer.width = 640;
+	buffer.height = 256;
+	buffer.format = PIXEL_RGBA;
+	buffer.data = new uint32_t[buffer.width * buffer.height];
+	buffer.indices = NULL;
+	buffer_clear(&buffer, 0);
+
+	const char* texts[] = {"SCORE", "CREDIT 00", "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789-"};
+	for(size_t t = 0; t < sizeof(texts) / sizeof(texts[0]); ++t)
+	{
+		BenchStats stats = bench_measure([&]
+		{
+			buffer_draw_text(&buffer, assets.text_spritesheet, texts[t], 4, 100, 0xff0000ff);
+			bench_keep(buffer.data[0]);
+		});
+		char name[64];
+		snprintf(name, sizeof(name), "draw_text/%lu_chars", strlen(texts[t]));
+		bench_report_add(report, name, stats, strlen(texts[t]));
+	}
+
+	// The same strings composited once by the text cache, then drawn strip by strip
+	Arena arena;
+	arena_init(&arena);
+	TextCache cache;
+	text_cache_init(&cache, &arena);
+	DrawList list;
+	draw_list_init(&list);
+	Rect clip = {0, 0, buffer.width, buffer.height};
+	for(size_t t = 0; t < sizeof(texts) / sizeof(texts[0]); ++t)
+	{
+		const CachedText* text = text_cache_get(&cache, assets.text_spritesheet, texts[t]);
+		BenchStats stats = bench_measure([&]
+		{
+			draw_list_reset(&list, 0);
+			text_cache_draw(&cache, &list, text, 4, 100, 0xff0000ff);
+			for(size_t i = 0; i < list.num_commands; ++i)
+			{
+				draw_command_render(&buffer, list.commands[i], clip);
+			}
+			bench_keep(buffer.data[0]);
+		});
+		char name[64];
+		snprintf(name, sizeof(name), "draw_cached_text/%lu_chars", strlen(texts[t]));
+		bench_report_add(report, name, stats, strlen(texts[t]));
+	}
+	draw_list_free(&list);
+	arena_free(&arena);
+
+	const size_t numbers[] = {0, 1230, 18446744073709551615ull};
+	const size_t num_digits[] = {1, 4, 20};
+	for(size_t n = 0; n < sizeof(numbers) / sizeof(numbers[0]); ++n)
+	{
+		BenchStats stats = bench_measure([&]
+		{
+			buffer_draw_number(&buffer, assets.number_spritesheet, numbers[n], 4, 100, 0xff0000ff);
+			bench_keep(buffer.data[0]);
+		});
+		char name[64];
+		snprintf(name, sizeof(name), "draw_number/%lu_digits", num_digits[n]);
+		bench_report_add(report, name, stats, num_digits[n]);
+	}
+	delete[] buffer.data;
+}
+
+static void bench_rgb(BenchReport* report)
+{
+	BenchStats stats = bench_measure([&]
+	{
+		uint32_t sum = 0;
+		for(uint32_t i = 0; i < 256; ++i)
+		{
+			sum += rgb_to_uint32(i, 255 - i, i ^ 0x55);
+		}
+		bench_keep(sum);
+	});
+	bench_report_add(report, "rgb_to_uint32/256_colors", stats, 256);
+}
+
+typedef bool (*OverlapCheck)(const Sprite&, size_t, size_t, const Sprite&, size_t, size_t);
+
+// Every pair of count aliens scattered over a game-sized area
+static void bench_overlap(BenchReport* report, const GameAssets& assets)
+{
+	const size_t counts[] = {10, 100, 1000};
+	struct { const char* name; OverlapCheck check; } checks[] = {
+		{"overlap_box", sprite_overlap_check},
+		{"overlap_pixel", sprite_pixel_overlap_check}
+	};
+	for(size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+	{
+		size_t count = counts[c];
+		size_t* x = new size_t[count];
+		size_t* y = new size_t[count];
+		const Sprite** sprites = new const Sprite*[count];
+		for(size_t i = 0; i < count; ++i)
+		{
+			x[i] = random_next() % 212;
+			y[i] = random_next() % 248;
+			sprites[i] = &assets.alien_sprites[2 * (random_next() % 3)];
+		}
+
+		for(size_t k = 0; k < sizeof(checks) / sizeof(checks[0]); ++k)
+		{
+			OverlapCheck check = checks[k].check;
+			BenchStats stats = bench_measure([&]
+			{
+				size_t hits = 0;
+				for(size_t a = 0; a < count; ++a)
+				{
+					for(size_t b = a + 1; b < count; ++b)
+					{
+						hits += check(*sprites[a], x[a], y[a], *sprites[b], x[b], y[b]);
+					}
+				}
+				bench_keep(hits);
+			});
+			char name[64];
+			snprintf(name, sizeof(name), "%s/%lu_entities", checks[k].name, count);
+			bench_report_add(report, name, stats, count * (count - 1) / 2);
+		}
+
+		delete[] x;
+		delete[] y;
+		delete[] sprites;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	BenchReport report;
+	if(!bench_report_init(&report, "primitives", argc, argv)) return 1;
+
+	const GameAssets& assets = game_assets;
+
+	bench_clear(&report);
+	bench_draw_sprite(&report, assets);
+	bench_text(&report, assets);
+	bench_rgb(&report);
+	bench_overlap(&report, assets);
+
+	bench_report_finish(&report);
+	return 0;
+}
@@ -0,0 +1,110 @@
+// Snapshot and restore latency and bytes per snapshot, for the game as
+// played and with growing numbers of bullets in flight. Also checks that
+// a game rewound through the snapshot ring replays to the same state
+#include <cstdio>
+#include <cstdint>
+#include "../assets.h"
+#include "../game.h"
+#include "../snapshot.h"
+#include "../timing.h"
+
+static GameInput scripted_input(size_t tick)
+{
+	GameInput input;
+	input.move_dir = ((tick / 100) % 2)? -1: 1;
+	input.fire_pressed = (tick % 8) == 0;
+	return input;
+}
+
+// Repeat operation until the measurement is long enough, returns ns per call
+template<typename Operation>
+static double time_calls(Operation operation)
+{
+	size_t calls = 0;
+	uint64_t start = time_ns();
+	uint64_t elapsed;
+	do
+	{
+		operation();
+		++calls;
+		elapsed = time_ns() - start;
+	}
+	while(elapsed < 50000000);
+	return (double)elapsed / calls;
+}
+
+int main()
+{
+	const GameAssets& assets = game_assets;
+	Arena arena;
+	arena_init(&arena);
+	Game game;
+	game_init(&game, &arena, &assets, 224, 256);
+	Game restored;
+	game_init(&restored, &arena, &assets, 224, 256);
+
+	// Rewind check: play 600 ticks keeping every snapshot, go back 300
+	// ticks, play them again and compare with the first time through
+	SnapshotRing ring;
+	snapshot_ring_init(&ring, 600, game_snapshot_size(game));
+	uint64_t hashes[600];
+	for(size_t tick = 0; tick < 600; ++tick)
+	{
+		snapshot_ring_push(&ring, game);
+		game_simulate(&game, scripted_input(tick));
+		hashes[tick] = game_hash(game);
+	}
+	bool rewound = snapshot_ring_rewind(&ring, &game, 299);
+	size_t mismatches = 0;
+	for(size_t tick = 300; tick < 600; ++tick)
+	{
+		game_simulate(&game, scripted_input(tick));
+		if(game_hash(game) != hashes[tick]) ++mismatches;
+	}
+	printf("Rewind 300 ticks and replay: %s\n", rewound && !mismatches? "same states": "MISMATCH");
+
+	// Bullets spread over the screen, moving so that none leave it between
+	// two measurements of the game as played
+	const size_t bullet_counts[] = {0, 10, 100, 1000, 10000, 100000};
+	printf("%8s %10s %10s %10s %12s %10s\n", "bullets", "bytes", "save us", "load us", "ring push us", "ok");
+	uint8_t* blob = NULL;
+	for(size_t c = 0; c < sizeof(bullet_counts) / sizeof(bullet_counts[0]); ++c)
+	{
+		game_reset(&game);
+		for(size_t tick = 0; tick < 300; ++tick)
+		{
+			game_simulate(&game, scripted_input(tick));
+		}
+		pool_clear(&game.bullets);
+		for(size_t i = 0; i < bullet_counts[c]; ++i)
+		{
+			Bullet bullet;
+			bullet.x = (i * 7) % 224;
+			bullet.y = 20 + (i * 13) % 200;
+			bullet.dir = 0;
+			pool_add(&game.bullets, bullet);
+		}
+
+		size_t size = game_snapshot_size(game);
+		delete[] blob;
+		blob = new uint8_t[size];
+		double save_ns = time_calls([&]{ game_snapshot_save(game, blob, size); });
+		double load_ns = time_calls([&]{ game_snapshot_load(&restored, blob, size); });
+		bool ok = game_hash(restored) == game_hash(game);
+
+		SnapshotRing bench_ring;
+		snapshot_ring_init(&bench_ring, 64, size);
+		double push_ns = time_calls([&]{ snapshot_ring_push(&bench_ring, game); });
+		snapshot_ring_free(&bench_ring);
+
+		printf("%8lu %10lu %10.2f %10.2f %12.2f %10s\n", bullet_counts[c], size,
+				save_ns / 1000, load_ns / 1000, push_ns / 1000, ok? "yes": "NO");
+	}
+	delete[] blob;
+
+	snapshot_ring_free(&ring);
+	game_free(&restored);
+	game_free(&game);
+	arena_free(&arena);
+	return 0;
+}
@@ -0,0 +1,103 @@
+// Frame raster time of draw_list_render against the tiled renderer on
+// 1 to 8 threads, for the game's buffer and for larger buffers filled
+// with a formation of aliens. Every tiled frame is checked against the
+// serial one
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include "../buffer.h"
+#include "../assets.h"
+#include "../draw_list.h"
+#include "../thread_pool.h"
+#include "../tile_renderer.h"
+#include "../timing.h"
+
+// A formation covering the buffer, 16 by 17 pixels per alien, with the
+// HUD of the game on top
+static void formation_list(DrawList* list, const GameAssets& assets, size_t width, size_t height)
+{
+	uint32_t red = rgb_to_uint32(128, 0, 0);
+	draw_list_reset(list, rgb_to_uint32(0, 128, 0));
+	draw_list_text(list, assets.text_spritesheet, "SCORE", 4, height - 14, red);
+	draw_list_number(list, assets.number_spritesheet, 1234, 4 + 2 * assets.number_spritesheet.width, height - 26, red);
+	draw_list_text(list, assets.text_spritesheet, "CREDIT 00", 164, 7, red);
+	draw_list_hline(list, 0, 16, width, red);
+	for(size_t y = 32; y + 17 < height - 32; y += 17)
+	{
+		for(size_t x = 4; x + 16 < width; x += 16)
+		{
+			draw_list_sprite(list, assets.alien_sprites[(x / 16 + y / 17) % 6], x, y, red);
+		}
+	}
+}
+
+// Repeat render until the measurement is long enough, returns ns per frame
+template<typename Render>
+static double time_frames(Render render)
+{
+	size_t frames = 0;
+	uint64_t start = time_ns();
+	uint64_t elapsed;
+	do
+	{
+		render();
+		++frames;
+		elapsed = time_ns() - start;
+	}
+	while(elapsed < 200000000);
+	return (double)elapsed / frames;
+}
+
+int main()
+{
+	const GameAssets& assets = game_assets;
+	DrawList list;
+	draw_list_init(&list);
+
+	const size_t sizes[][2] = {{224, 256}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+	const size_t thread_counts[] = {1, 2, 4, 8};
+
+	printf("Hardware threads: %lu\n", thread_pool_hardware_threads());
+	printf("%11s %9s %12s %8s %12s %8s %6s\n",
+			"buffer", "commands", "serial us", "threads", "tiled us", "speedup", "same");
+	for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+	{
+		Buffer serial = {sizes[s][0], sizes[s][1], PIXEL_RGBA, new uint32_t[sizes[s][0] * sizes[s][1]], NULL};
+		Buffer tiled = {sizes[s][0], sizes[s][1], PIXEL_RGBA, new uint32_t[sizes[s][0] * sizes[s][1]], NULL};
+		formation_list(&list, assets, serial.width, serial.height);
+
+		double serial_ns = time_frames([&]{ draw_list_render(&serial, list); });
+
+		for(size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); ++t)
+		{
+			ThreadPool pool;
+			thread_pool_init(&pool, thread_counts[t]);
+			TileRenderer renderer;
+			tile_renderer_init(&renderer, &pool, tiled.height);
+			Arena scratch;
+			arena_init(&scratch);
+
+			memset(tiled.data, 0, tiled.width * tiled.height * sizeof(uint32_t));
+			double tiled_ns = time_frames([&]
+			{
+				tile_renderer_render(&renderer, &tiled, list, &scratch);
+				arena_reset(&scratch);
+			});
+			bool same = memcmp(serial.data, tiled.data, tiled.width * tiled.height * sizeof(uint32_t)) == 0;
+
+			char name[32];
+			snprintf(name, sizeof(name), "%lux%lu", serial.width, serial.height);
+			printf("%11s %9lu %12.1f %8lu %12.1f %8.2f %6s\n", name, list.num_commands,
+					serial_ns / 1000, thread_counts[t], tiled_ns / 1000, serial_ns / tiled_ns, same? "yes": "NO");
+
+			arena_free(&scratch);
+			thread_pool_free(&pool);
+		}
+
+		delete[] serial.data;
+		delete[] tiled.data;
+	}
+
+	draw_list_free(&list);
+	return 0;
+}
@@ -0,0 +1,183 @@
+#include <cstring>
+#include "buffer.h"
+#include "simd.h"
+
+// Mask with the low n bits set
+static uint32_t low_bits(size_t n)
+{
+	return n >= SPRITE_MAX_WIDTH? 0xffffffffu: (1u << n) - 1;
+}
+
+// Intersection of the rectangle with the buffer area
+static Rect clip_to_buffer(const Buffer* buffer, const Rect& rect)
+{
+	Rect clip = rect;
+	if(clip.x1 > buffer->width) clip.x1 = buffer->width;
+	if(clip.y1 > buffer->height) clip.y1 = buffer->height;
+	return clip;
+}
+
+void buffer_draw_sprite(Buffer* buffer, const Sprite& sprite, size_t x, size_t y, uint32_t color)
+{
+	Rect clip = {0, 0, buffer->width, buffer->height};
+	buffer_draw_sprite_clipped(buffer, sprite, x, y, color, clip);
+}
+
+// Clips the sprite once, to a row range and a column mask, then hands the rows
+// to the blit kernel of the selected instruction set. Whole rows of the common
+// sprite sizes go to a kernel specialized for the size
+void buffer_draw_sprite_clipped(Buffer* buffer, const Sprite& sprite, size_t x, size_t y,
+		uint32_t color, const Rect& rect)
+{
+	Rect clip = clip_to_buffer(buffer, rect);
+	if(x >= clip.x1 || x + sprite.width <= clip.x0) return;
+
+	// Buffer row of the top sprite row; sprite row yi lands on buffer row top - yi
+	size_t top = y + sprite.height - 1;
+	if(top < clip.y0) return;
+	size_t yi_begin = top >= clip.y1? top - clip.y1 + 1: 0;
+	size_t yi_end = top - clip.y0 + 1;
+	if(yi_end > sprite.height) yi_end = sprite.height;
+	if(yi_begin >= yi_end) return;
+
+	uint32_t column_mask = low_bits(clip.x1 - x);
+	if(clip.x0 > x) column_mask &= ~low_bits(clip.x0 - x);
+
+	size_t index = NUM_SPRITE_BLIT_SIZES;
+	if(yi_begin == 0 && yi_end == sprite.height) index = sprite_blit_index(sprite.width, sprite.height);
+	size_t offset = (top - yi_begin) * buffer->width + x;
+	if(buffer->format == PIXEL_INDEXED)
+	{
+		SpriteBlit8 blit = index < NUM_SPRITE_BLIT_SIZES?
+			raster_kernels.blit_sprite8_fixed[index]: raster_kernels.blit_sprite8;
+		blit(buffer->indices + offset, buffer->width,
+			sprite.rows + yi_begin, yi_end - yi_begin, column_mask, color);
+	}
+	else
+	{
+		SpriteBlit blit = index < NUM_SPRITE_BLIT_SIZES?
+			raster_kernels.blit_sprite_fixed[index]: raster_kernels.blit_sprite;
+		blit(buffer->data + offset, buffer->width,
+			sprite.rows + yi_begin, yi_end - yi_begin, column_mask, color);
+	}
+}
+
+// Draw the text as a sprite at specified coordinates and with specified color
+void buffer_draw_text(Buffer *buffer, const Sprite& text_spritesheet, const char* text,
+				size_t x, size_t y, uint32_t color){
+		size_t xp = x;
+		// stride is the number of rows of one character sprite
+		size_t stride = text_spritesheet.height;
+		Sprite sprite = text_spritesheet;
+		// iterate through all the characters in the text until the null character
+		for(const char* charp = text; *charp != '\0'; ++charp)
+		{
+			char character = *charp - 32;
+			if (character < 0 || character >= 65) continue;
+			sprite.rows = text_spritesheet.rows + character * stride;
+			buffer_draw_sprite(buffer, sprite, xp, y, color);
+			xp += sprite.width + 1;
+		}
+}
+
+// Draw numbers
+void buffer_draw_number(Buffer* buffer, const Sprite& number_spritesheet, size_t number,
+				size_t x, size_t y, uint32_t color)
+{
+		uint8_t digits[64];
+		size_t num_digits = 0;
+
+		size_t current_number = number;
+		// Getting digits of the number
+		do
+		{
+				digits[num_digits++] = current_number % 10;
+				current_number = current_number / 10;
+		}
+		while(current_number > 0);
+		size_t xp = x;
+		size_t stride = number_spritesheet.height;
+		Sprite sprite = number_spritesheet;
+		for(size_t i = 0; i < num_digits; ++i)
+		{
+				uint8_t digit = digits[num_digits - i - 1];
+				sprite.rows = number_spritesheet.rows + digit * stride;
+				buffer_draw_sprite(buffer, sprite, xp, y, color);
+				xp += sprite.width + 1;
+		}
+
+}
+
+// Sets the left most 24 bits to the r,g,b values respectively
+// the right-most 8 bits are set to 255 (but not used)
+uint32_t rgb_to_uint32(uint8_t r, uint8_t g, uint8_t b)
+{
+	return (r << 24) | (g << 16) | (b << 8) | 255;
+}
+// Set count pixels from pixel offset on to color. Indices are filled by memset,
+// which the C library already vectorizes
+static void buffer_fill(Buffer* buffer, size_t offset, size_t count, uint32_t color)
+{
+	if(buffer->format == PIXEL_INDEXED) memset(buffer->indices + offset, (uint8_t)color, count);
+	else raster_kernels.fill(buffer->data + offset, count, color);
+}
+
+// Clear the buffer to a certain color
+void buffer_clear(Buffer* buffer, uint32_t color)
+{
+	buffer_fill(buffer, 0, buffer->width * buffer->height, color);
+}
+
+void buffer_fill_rect(Buffer* buffer, const Rect& rect, uint32_t color)
+{
+	Rect clip = clip_to_buffer(buffer, rect);
+	if(clip.x0 >= clip.x1) return;
+	for(size_t y = clip.y0; y < clip.y1; ++y)
+	{
+		buffer_fill(buffer, y * buffer->width + clip.x0, clip.x1 - clip.x0, color);
+	}
+}
+
+// Draw a horizontal line of width pixels starting at x, clipped to the buffer
+void buffer_draw_hline(Buffer* buffer, size_t x, size_t y, size_t width, uint32_t color)
+{
+	if(y >= buffer->height || x >= buffer->width) return;
+	if(width > buffer->width - x) width = buffer->width - x;
+	buffer_fill(buffer, y * buffer->width + x, width, color);
+}
+
+bool sprite_overlap_check(
+		const Sprite& sp_a, size_t x_a, size_t y_a,
+		const Sprite& sp_b, size_t x_b, size_t y_b)
+{
+	if(x_a < x_b + sp_b.width && x_a + sp_a.width > x_b &&
+			y_a < y_b + sp_b.height && y_a + sp_a.height > y_b)
+	{
+		return true;
+	}
+
+	return false;
+}
+
+bool sprite_pixel_overlap_check(
+		const Sprite& sp_a, size_t x_a, size_t y_a,
+		const Sprite& sp_b, size_t x_b, size_t y_b)
+{
+	if(!sprite_overlap_check(sp_a, x_a, y_a, sp_b, x_b, y_b)) return false;
+
+	// Shift the masks so that bit i of both is the same column
+	unsigned shift_a = x_a > x_b? x_a - x_b: 0;
+	unsigned shift_b = x_b > x_a? x_b - x_a: 0;
+
+	// Buffer rows covered by both sprites; sprite row yi lies on buffer row y + height - 1 - yi
+	size_t y_begin = y_a > y_b? y_a: y_b;
+	size_t y_end = y_a + sp_a.height < y_b + sp_b.height? y_a + sp_a.height: y_b + sp_b.height;
+	const uint32_t* row_a = sp_a.rows + (y_a + sp_a.height - 1 - y_begin);
+	const uint32_t* row_b = sp_b.rows + (y_b + sp_b.height - 1 - y_begin);
+	for(size_t y = y_begin; y < y_end; ++y, --row_a, --row_b)
+	{
+		if(((uint64_t)*row_a << shift_a) & ((uint64_t)*row_b << shift_b)) return true;
+	}
+
+	return false;
+}
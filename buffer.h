@@ -0,0 +1,104 @@
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+
+enum PixelFormat
+{
+	// 32-bit RGBA pixels in data
+	PIXEL_RGBA,
+	// 8-bit palette indices in indices, the colors are looked up when displayed
+	PIXEL_INDEXED
+};
+
+// Colors a palette holds. The shader keeps the palette in uniforms, so it is kept small
+#define PALETTE_SIZE 16
+
+// Colors by index, as returned by rgb_to_uint32
+struct Palette
+{
+	uint32_t colors[PALETTE_SIZE];
+};
+
+// Buffer represents pixels on the screen. The color passed to the buffer_*
+// functions is stored as is: an RGBA value, or a palette index for PIXEL_INDEXED
+struct Buffer
+{
+	size_t width, height;
+	PixelFormat format;
+	// Using uint32_t allows to store 4 8-bit color values for each pixel
+	uint32_t* data;
+	uint8_t* indices;
+};
+
+// Bytes a pixel takes in the buffer, and in the texture it is uploaded to
+inline size_t pixel_format_size(PixelFormat format)
+{
+	return format == PIXEL_INDEXED? sizeof(uint8_t): sizeof(uint32_t);
+}
+
+// Rectangle of pixels [x0, x1) x [y0, y1), y counted from the bottom of the buffer
+struct Rect
+{
+	size_t x0, y0, x1, y1;
+};
+
+// Sprite represented as a bitmap -- each pixel represented by a single bit 1 == on.
+// A sprite owns nothing: its pixels are const tables in read-only data for
+// the built-in assets (assets.cpp), or live in a mapped asset pack or a
+// TextCache, which outlive the sprites pointing into them
+struct Sprite
+{
+	size_t width, height;
+	// One byte per pixel, row by row from the top, as the built-in sprites
+	// are written. NULL for sprites that only have their row masks
+	const uint8_t* data;
+	// Form used for drawing: one mask per row, top row first, bit i of a
+	// mask is the pixel at column i
+	const uint32_t* rows;
+};
+
+// Widest sprite that fits in a row mask
+#define SPRITE_MAX_WIDTH 32
+
+// Sets the left most 24 bits to the r,g,b values respectively
+// the right-most 8 bits are set to 255 (but not used)
+uint32_t rgb_to_uint32(uint8_t r, uint8_t g, uint8_t b);
+
+// Clear the buffer to a certain color
+void buffer_clear(Buffer* buffer, uint32_t color);
+
+// Fill the part of the rectangle that lies inside the buffer
+void buffer_fill_rect(Buffer* buffer, const Rect& rect, uint32_t color);
+
+// Draw a horizontal line of width pixels starting at x, clipped to the buffer
+void buffer_draw_hline(Buffer* buffer, size_t x, size_t y, size_t width, uint32_t color);
+
+// Draws "on" pixels of the sprite at specified coordinates if within buffer bounds
+void buffer_draw_sprite(Buffer* buffer, const Sprite& sprite, size_t x, size_t y, uint32_t color);
+
+// Same as buffer_draw_sprite, but only touches pixels inside clip
+void buffer_draw_sprite_clipped(Buffer* buffer, const Sprite& sprite, size_t x, size_t y,
+		uint32_t color, const Rect& clip);
+
+// Draw the text as a sprite at specified coordinates and with specified color
+void buffer_draw_text(Buffer* buffer, const Sprite& text_spritesheet, const char* text,
+		size_t x, size_t y, uint32_t color);
+
+// Draw numbers
+void buffer_draw_number(Buffer* buffer, const Sprite& number_spritesheet, size_t number,
+		size_t x, size_t y, uint32_t color);
+
+// Bounding box overlap of two sprites
+bool sprite_overlap_check(
+		const Sprite& sp_a, size_t x_a, size_t y_a,
+		const Sprite& sp_b, size_t x_b, size_t y_b);
+
+// True if an "on" pixel of one sprite covers an "on" pixel of the other.
+// Tests the bounding boxes first, then ANDs the overlapping row masks
+bool sprite_pixel_overlap_check(
+		const Sprite& sp_a, size_t x_a, size_t y_a,
+		const Sprite& sp_b, size_t x_b, size_t y_b);
+
+#endif
@@ -0,0 +1,191 @@
+#include <cstring>
+#include "capture.h"
+#include "timing.h"
+
+static bool ends_with(const char* text, const char* suffix)
+{
+	size_t length = strlen(text), suffix_length = strlen(suffix);
+	return length >= suffix_length && strcmp(text + length - suffix_length, suffix) == 0;
+}
+
+// Color of pixel i of a slot, as returned by rgb_to_uint32
+static inline uint32_t capture_pixel(const CaptureSlot& slot, size_t i)
+{
+	if(slot.format == PIXEL_INDEXED) return slot.palette.colors[slot.pixels[i]];
+	return ((const uint32_t*)slot.pixels)[i];
+}
+
+// Convert a slot into the output frame, flipped so the top row comes first
+static void capture_convert(Capture* capture, const CaptureSlot& slot)
+{
+	size_t width = capture->width, height = capture->height;
+	uint8_t* out = capture->output;
+	if(capture->format == CAPTURE_Y4M)
+	{
+		static const char frame_header[] = "FRAME\n";
+		memcpy(out, frame_header, sizeof(frame_header) - 1);
+		uint8_t* y_plane = out + sizeof(frame_header) - 1;
+		uint8_t* u_plane = y_plane + width * height;
+		uint8_t* v_plane = u_plane + width * height;
+		for(size_t yi = 0; yi < height; ++yi)
+		{
+			size_t row = (height - 1 - yi) * width;
+			for(size_t xi = 0; xi < width; ++xi)
+			{
+				uint32_t color = capture_pixel(slot, row + xi);
+				int r = color >> 24, g = (color >> 16) & 0xff, b = (color >> 8) & 0xff;
+				// BT.601, limited range
+				size_t o = yi * width + xi;
+				y_plane[o] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+				u_plane[o] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+				v_plane[o] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+			}
+		}
+	}
+	else
+	{
+		for(size_t yi = 0; yi < height; ++yi)
+		{
+			size_t row = (height - 1 - yi) * width;
+			uint8_t* line = out + yi * width * 4;
+			for(size_t xi = 0; xi < width; ++xi)
+			{
+				uint32_t color = capture_pixel(slot, row + xi);
+				line[4 * xi + 0] = color >> 24;
+				line[4 * xi + 1] = (color >> 16) & 0xff;
+				line[4 * xi + 2] = (color >> 8) & 0xff;
+				line[4 * xi + 3] = color & 0xff;
+			}
+		}
+	}
+}
+
+static void capture_run(Capture* capture)
+{
+	for(;;)
+	{
+		// Once quit is seen every frame queued before it is visible too
+		bool quitting = capture->quit.load(std::memory_order_acquire);
+		size_t tail = capture->tail.load(std::memory_order_relaxed);
+		if(tail == capture->head.load(std::memory_order_acquire))
+		{
+			if(quitting) break;
+			// Polled rather than woken by the game thread, which would hand
+			// the writer its time slice when they share a core
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		uint64_t start = time_ns();
+		const CaptureSlot& slot = capture->slots[tail % CAPTURE_RING_SIZE];
+		size_t repeat = slot.repeat;
+		capture_convert(capture, slot);
+		capture->tail.store(tail + 1, std::memory_order_release);
+		for(size_t i = 0; i < repeat; ++i)
+		{
+			if(!capture->failed && fwrite(capture->output, 1, capture->output_size, capture->file) != capture->output_size)
+			{
+				capture->failed = true;
+			}
+		}
+		capture->write_ns += time_ns() - start;
+		capture->written += repeat;
+		capture->bytes += repeat * capture->output_size;
+	}
+}
+
+bool capture_open(Capture* capture, Arena* arena, const char* path, size_t width, size_t height,
+		double fps, bool wait_when_full)
+{
+	capture->file = fopen(path, "wb");
+	if(!capture->file) return false;
+	// Frames go out in single writes larger than any stdio buffer
+	setvbuf(capture->file, NULL, _IONBF, 0);
+
+	capture->format = ends_with(path, ".y4m")? CAPTURE_Y4M: CAPTURE_RAW_RGBA;
+	capture->width = width;
+	capture->height = height;
+	capture->wait_when_full = wait_when_full;
+	for(size_t i = 0; i < CAPTURE_RING_SIZE; ++i)
+	{
+		capture->slots[i].pixels = arena_alloc_array<uint8_t>(arena, width * height * 4);
+	}
+	capture->output_size = capture->format == CAPTURE_Y4M? 6 + width * height * 3: width * height * 4;
+	capture->output = arena_alloc_array<uint8_t>(arena, capture->output_size);
+
+	if(capture->format == CAPTURE_Y4M)
+	{
+		// Frame rate as a fraction in thousandths, square pixels, progressive
+		fprintf(capture->file, "YUV4MPEG2 W%lu H%lu F%lu:1000 Ip A1:1 C444\n",
+				width, height, (size_t)(fps * 1000 + 0.5));
+	}
+
+	capture->head.store(0, std::memory_order_relaxed);
+	capture->tail.store(0, std::memory_order_relaxed);
+	capture->quit.store(false, std::memory_order_relaxed);
+	capture->frames = capture->dropped = 0;
+	capture->dropped_repeat = 0;
+	capture->copy_sum_ns = 0;
+	capture->copy_max_ns = 0;
+	capture->written = 0;
+	capture->bytes = 0;
+	capture->write_ns = 0;
+	capture->failed = false;
+	capture->writer = std::thread(capture_run, capture);
+	return true;
+}
+
+void capture_frame(Capture* capture, const Buffer& buffer, const Palette& palette, size_t repeat)
+{
+	uint64_t start = time_ns();
+	++capture->frames;
+	size_t head = capture->head.load(std::memory_order_relaxed);
+	while(head - capture->tail.load(std::memory_order_acquire) == CAPTURE_RING_SIZE)
+	{
+		if(!capture->wait_when_full)
+		{
+			// The next frame is shown for longer instead, so the video
+			// keeps the time of the game
+			++capture->dropped;
+			capture->dropped_repeat += repeat;
+			return;
+		}
+		std::this_thread::yield();
+	}
+
+	CaptureSlot& slot = capture->slots[head % CAPTURE_RING_SIZE];
+	slot.format = buffer.format;
+	slot.repeat = repeat + capture->dropped_repeat;
+	capture->dropped_repeat = 0;
+	if(buffer.format == PIXEL_INDEXED)
+	{
+		slot.palette = palette;
+		memcpy(slot.pixels, buffer.indices, buffer.width * buffer.height);
+	}
+	else
+	{
+		memcpy(slot.pixels, buffer.data, buffer.width * buffer.height * 4);
+	}
+	capture->head.store(head + 1, std::memory_order_release);
+
+	uint64_t elapsed = time_ns() - start;
+	capture->copy_sum_ns += elapsed;
+	if(elapsed > capture->copy_max_ns) capture->copy_max_ns = elapsed;
+}
+
+void capture_close(Capture* capture)
+{
+	capture->quit.store(true, std::memory_order_release);
+	capture->writer.join();
+	fclose(capture->file);
+	capture->file = NULL;
+}
+
+void capture_print_stats(const Capture& capture)
+{
+	double megabytes = capture.bytes / 1e6;
+	printf("Capture: %lu video frames written, %lu frames dropped, %.1f MB at %.0f MB/s, %.1f us mean, %.1f us max to queue a frame\n",
+			capture.written, capture.dropped, megabytes, capture.write_ns? megabytes * 1e9 / capture.write_ns: 0.0,
+			capture.frames? capture.copy_sum_ns / 1e3 / capture.frames: 0.0, capture.copy_max_ns / 1e3);
+	if(capture.failed) fprintf(stderr, "Writing the capture failed, the file is incomplete.\n");
+}
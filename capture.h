@@ -0,0 +1,85 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include "arena.h"
+#include "buffer.h"
+
+// Frames waiting to be written at most
+#define CAPTURE_RING_SIZE 8
+
+enum CaptureFormat
+{
+	// Bytes R, G, B, A per pixel, top row first, no header:
+	// ffmpeg -f rawvideo -pix_fmt rgba -s WxH -r FPS -i FILE
+	CAPTURE_RAW_RGBA,
+	// YUV4MPEG2 with full resolution chroma (C444), playable as is
+	CAPTURE_Y4M
+};
+
+// A frame as the game thread left it, converted by the writer
+struct CaptureSlot
+{
+	PixelFormat format;
+	Palette palette;
+	// Pixels of the buffer, 1 or 4 bytes each, bottom row first
+	uint8_t* pixels;
+	// Video frames to write it as
+	size_t repeat;
+};
+
+// Writes every frame it is given to a video file. The game thread only copies
+// the buffer into a slot of a preallocated ring; a writer thread converts the
+// frames and writes each one with a single large write. When the ring is full
+// the frame is dropped, or waited for with wait_when_full, so that a window
+// never stalls on the disk and a headless run loses no frames
+struct Capture
+{
+	FILE* file;
+	CaptureFormat format;
+	size_t width, height;
+	bool wait_when_full;
+	CaptureSlot slots[CAPTURE_RING_SIZE];
+	// Frame converted to the file format, used by the writer only
+	uint8_t* output;
+	size_t output_size;
+	// Slots filled by the game thread and written by the writer
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+	std::atomic<bool> quit;
+	std::thread writer;
+	// Game thread: frames given, frames dropped, time spent copying them
+	size_t frames;
+	size_t dropped;
+	// Video frames of the dropped frames, added to the next one queued
+	size_t dropped_repeat;
+	double copy_sum_ns;
+	uint64_t copy_max_ns;
+	// Writer: frames and bytes written, time spent converting and writing
+	size_t written;
+	uint64_t bytes;
+	uint64_t write_ns;
+	bool failed;
+};
+
+// Create the file and start the writer. The format comes from the extension
+// of path: .y4m for Y4M, raw RGBA otherwise. The slots come from the arena.
+// Returns false if the file cannot be created
+bool capture_open(Capture* capture, Arena* arena, const char* path, size_t width, size_t height,
+		double fps, bool wait_when_full);
+
+// Queue the buffer contents, drawn with palette, to be written as repeat
+// video frames: the video runs at fps, so a frame standing for several
+// ticks of a game running at that rate is shown for as many video frames
+void capture_frame(Capture* capture, const Buffer& buffer, const Palette& palette, size_t repeat);
+
+// Write the frames still queued, stop the writer and close the file
+void capture_close(Capture* capture);
+
+void capture_print_stats(const Capture& capture);
+
+#endif
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cstring>
+#include "dirty_rect.h"
+#include "profiler.h"
+
+void dirty_tracker_init(DirtyTracker* tracker)
+{
+	draw_list_init(&tracker->previous);
+	tracker->valid = false;
+	tracker->num_rects = 0;
+	tracker->dirty_pixels = 0;
+	tracker->upload_bytes = 0;
+}
+
+void dirty_tracker_free(DirtyTracker* tracker)
+{
+	draw_list_free(&tracker->previous);
+}
+
+void dirty_tracker_invalidate(DirtyTracker* tracker)
+{
+	tracker->valid = false;
+}
+
+static bool command_less(const DrawCommand& a, const DrawCommand& b)
+{
+	if(a.rows != b.rows) return a.rows < b.rows;
+	if(a.x != b.x) return a.x < b.x;
+	if(a.y != b.y) return a.y < b.y;
+	if(a.width != b.width) return a.width < b.width;
+	if(a.height != b.height) return a.height < b.height;
+	return a.color < b.color;
+}
+
+static size_t rect_area(const Rect& rect)
+{
+	return (rect.x1 - rect.x0) * (rect.y1 - rect.y0);
+}
+
+static bool rect_overlap(const Rect& a, const Rect& b)
+{
+	return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+static Rect rect_union(const Rect& a, const Rect& b)
+{
+	Rect rect = {
+		std::min(a.x0, b.x0), std::min(a.y0, b.y0),
+		std::max(a.x1, b.x1), std::max(a.y1, b.y1)
+	};
+	return rect;
+}
+
+// Add a rectangle to the set, merging it with the rectangles it overlaps so
+// that the set stays disjoint, or with the cheapest one if the set is full
+static void add_rect(DirtyTracker* tracker, Rect rect, const Buffer& buffer)
+{
+	if(rect.x1 > buffer.width) rect.x1 = buffer.width;
+	if(rect.y1 > buffer.height) rect.y1 = buffer.height;
+	if(rect.x0 >= rect.x1 || rect.y0 >= rect.y1) return;
+
+	for(;;)
+	{
+		size_t merge = tracker->num_rects;
+		for(size_t i = 0; i < tracker->num_rects; ++i)
+		{
+			if(rect_overlap(rect, tracker->rects[i]))
+			{
+				merge = i;
+				break;
+			}
+		}
+
+		if(merge == tracker->num_rects && tracker->num_rects == DIRTY_MAX_RECTS)
+		{
+			size_t best_growth = (size_t)-1;
+			for(size_t i = 0; i < tracker->num_rects; ++i)
+			{
+				size_t growth = rect_area(rect_union(rect, tracker->rects[i])) - rect_area(tracker->rects[i]);
+				if(growth < best_growth)
+				{
+					best_growth = growth;
+					merge = i;
+				}
+			}
+		}
+
+		if(merge == tracker->num_rects) break;
+
+		rect = rect_union(rect, tracker->rects[merge]);
+		tracker->rects[merge] = tracker->rects[--tracker->num_rects];
+	}
+
+	tracker->rects[tracker->num_rects++] = rect;
+}
+
+// Mark the area of every command that is in only one of the two lists
+static void diff_commands(DirtyTracker* tracker, const DrawList& list, const Buffer& buffer, Arena* scratch)
+{
+	const DrawList& previous = tracker->previous;
+	size_t num_a = previous.num_commands;
+	size_t num_b = list.num_commands;
+	DrawCommand* a = arena_alloc_array<DrawCommand>(scratch, num_a);
+	DrawCommand* b = arena_alloc_array<DrawCommand>(scratch, num_b);
+	memcpy(a, previous.commands, num_a * sizeof(DrawCommand));
+	memcpy(b, list.commands, num_b * sizeof(DrawCommand));
+	std::sort(a, a + num_a, command_less);
+	std::sort(b, b + num_b, command_less);
+
+	size_t i = 0, j = 0;
+	while(i < num_a || j < num_b)
+	{
+		if(j == num_b || (i < num_a && command_less(a[i], b[j])))
+		{
+			add_rect(tracker, draw_command_rect(a[i++]), buffer);
+		}
+		else if(i == num_a || command_less(b[j], a[i]))
+		{
+			add_rect(tracker, draw_command_rect(b[j++]), buffer);
+		}
+		else
+		{
+			++i;
+			++j;
+		}
+	}
+}
+
+// Whether pixels that are drawn the same in both lists can still differ
+static bool colors_changed(const DirtyTracker& tracker, const Buffer& buffer, const DrawList& list)
+{
+	const DrawList& previous = tracker.previous;
+	if(previous.clear_color != list.clear_color) return true;
+	if((previous.palette == NULL) != (list.palette == NULL)) return true;
+	// An indexed buffer holds the same indices whatever colors they stand for
+	return list.palette && buffer.format == PIXEL_RGBA &&
+		memcmp(&tracker.palette, list.palette, sizeof(Palette)) != 0;
+}
+
+void dirty_tracker_render(DirtyTracker* tracker, Buffer* buffer, const DrawList& list, Arena* scratch)
+{
+	PROFILE_SCOPE("dirty rects");
+	tracker->num_rects = 0;
+	if(!tracker->valid || colors_changed(*tracker, *buffer, list))
+	{
+		Rect full = {0, 0, buffer->width, buffer->height};
+		tracker->rects[tracker->num_rects++] = full;
+	}
+	else
+	{
+		diff_commands(tracker, list, *buffer, scratch);
+	}
+
+	tracker->dirty_pixels = 0;
+	for(size_t i = 0; i < tracker->num_rects; ++i)
+	{
+		draw_list_render_clipped(buffer, list, tracker->rects[i]);
+		tracker->dirty_pixels += rect_area(tracker->rects[i]);
+	}
+	tracker->upload_bytes = tracker->dirty_pixels * pixel_format_size(buffer->format);
+
+	// Remember what is now in the buffer
+	DrawList& previous = tracker->previous;
+	if(list.num_commands > previous.capacity)
+	{
+		delete[] previous.commands;
+		previous.capacity = list.capacity;
+		previous.commands = new DrawCommand[previous.capacity];
+	}
+	memcpy(previous.commands, list.commands, list.num_commands * sizeof(DrawCommand));
+	previous.num_commands = list.num_commands;
+	previous.clear_color = list.clear_color;
+	previous.palette = list.palette;
+	if(list.palette) tracker->palette = *list.palette;
+	tracker->valid = true;
+}
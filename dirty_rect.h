@@ -0,0 +1,42 @@
+#ifndef DIRTY_RECT_H
+#define DIRTY_RECT_H
+
+#include <cstddef>
+#include <cstdint>
+#include "arena.h"
+#include "buffer.h"
+#include "draw_list.h"
+
+// Past this many rectangles the closest ones are merged together
+#define DIRTY_MAX_RECTS 32
+
+// Keeps the buffer in sync with the draw lists of successive frames by only
+// clearing and redrawing the regions where the two lists differ
+struct DirtyTracker
+{
+	// Commands of the frame currently in the buffer
+	DrawList previous;
+	// False until the buffer holds a frame drawn by the tracker
+	bool valid;
+	// Colors of the palette of previous when it was drawn
+	Palette palette;
+	// Disjoint rectangles redrawn in the last frame
+	size_t num_rects;
+	Rect rects[DIRTY_MAX_RECTS];
+	// Pixels redrawn and bytes to upload in the last frame
+	size_t dirty_pixels;
+	size_t upload_bytes;
+};
+
+void dirty_tracker_init(DirtyTracker* tracker);
+void dirty_tracker_free(DirtyTracker* tracker);
+
+// Forget the buffer contents, the next frame is redrawn completely
+void dirty_tracker_invalidate(DirtyTracker* tracker);
+
+// Bring the buffer from the previous frame to the one described by list.
+// The sorted copies of the two lists it compares are allocated from scratch,
+// which the caller resets once the frame is drawn
+void dirty_tracker_render(DirtyTracker* tracker, Buffer* buffer, const DrawList& list, Arena* scratch);
+
+#endif
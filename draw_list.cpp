@@ -0,0 +1,152 @@
+#include <cstring>
+#include "draw_list.h"
+#include "profiler.h"
+
+void draw_list_init(DrawList* list)
+{
+	list->palette = NULL;
+	list->clear_color = 0;
+	list->num_commands = 0;
+	list->capacity = 256;
+	list->commands = new DrawCommand[list->capacity];
+}
+
+void draw_list_free(DrawList* list)
+{
+	delete[] list->commands;
+	list->commands = NULL;
+	list->num_commands = list->capacity = 0;
+}
+
+void draw_list_reset(DrawList* list, uint32_t clear_color, const Palette* palette)
+{
+	list->palette = palette;
+	list->clear_color = clear_color;
+	list->num_commands = 0;
+}
+
+static void draw_list_push(DrawList* list, const uint32_t* rows,
+		size_t x, size_t y, size_t width, size_t height, uint32_t color)
+{
+	if(list->num_commands == list->capacity)
+	{
+		DrawCommand* commands = new DrawCommand[2 * list->capacity];
+		memcpy(commands, list->commands, list->num_commands * sizeof(DrawCommand));
+		delete[] list->commands;
+		list->commands = commands;
+		list->capacity *= 2;
+	}
+	DrawCommand& command = list->commands[list->num_commands++];
+	command.rows = rows;
+	command.x = x;
+	command.y = y;
+	command.width = width;
+	command.height = height;
+	command.color = color;
+}
+
+void draw_list_sprite(DrawList* list, const Sprite& sprite, size_t x, size_t y, uint32_t color)
+{
+	draw_list_push(list, sprite.rows, x, y, sprite.width, sprite.height, color);
+}
+
+void draw_list_text(DrawList* list, const Sprite& text_spritesheet, const char* text,
+		size_t x, size_t y, uint32_t color)
+{
+	size_t xp = x;
+	size_t stride = text_spritesheet.height;
+	for(const char* charp = text; *charp != '\0'; ++charp)
+	{
+		char character = *charp - 32;
+		if (character < 0 || character >= 65) continue;
+		draw_list_push(list, text_spritesheet.rows + character * stride,
+				xp, y, text_spritesheet.width, text_spritesheet.height, color);
+		xp += text_spritesheet.width + 1;
+	}
+}
+
+void draw_list_number(DrawList* list, const Sprite& number_spritesheet, size_t number,
+		size_t x, size_t y, uint32_t color)
+{
+	uint8_t digits[64];
+	size_t num_digits = 0;
+
+	size_t current_number = number;
+	do
+	{
+		digits[num_digits++] = current_number % 10;
+		current_number = current_number / 10;
+	}
+	while(current_number > 0);
+
+	size_t xp = x;
+	size_t stride = number_spritesheet.height;
+	for(size_t i = 0; i < num_digits; ++i)
+	{
+		uint8_t digit = digits[num_digits - i - 1];
+		draw_list_push(list, number_spritesheet.rows + digit * stride,
+				xp, y, number_spritesheet.width, number_spritesheet.height, color);
+		xp += number_spritesheet.width + 1;
+	}
+}
+
+void draw_list_hline(DrawList* list, size_t x, size_t y, size_t width, uint32_t color)
+{
+	draw_list_push(list, NULL, x, y, width, 1, color);
+}
+
+Rect draw_command_rect(const DrawCommand& command)
+{
+	Rect rect = {command.x, command.y, command.x + command.width, command.y + command.height};
+	return rect;
+}
+
+void draw_command_render(Buffer* buffer, const DrawCommand& command, const Rect& clip,
+		const Palette* palette)
+{
+	uint32_t color = draw_list_pixel(*buffer, palette, command.color);
+	if(command.rows)
+	{
+		Sprite sprite;
+		sprite.width = command.width;
+		sprite.height = command.height;
+		sprite.data = NULL;
+		sprite.rows = command.rows;
+		buffer_draw_sprite_clipped(buffer, sprite, command.x, command.y, color, clip);
+	}
+	else
+	{
+		Rect rect = draw_command_rect(command);
+		if(rect.x0 < clip.x0) rect.x0 = clip.x0;
+		if(rect.y0 < clip.y0) rect.y0 = clip.y0;
+		if(rect.x1 > clip.x1) rect.x1 = clip.x1;
+		if(rect.y1 > clip.y1) rect.y1 = clip.y1;
+		if(rect.y0 < rect.y1) buffer_fill_rect(buffer, rect, color);
+	}
+}
+
+void draw_list_render(Buffer* buffer, const DrawList& list)
+{
+	Rect clip = {0, 0, buffer->width, buffer->height};
+	{
+		PROFILE_SCOPE("clear");
+		buffer_clear(buffer, draw_list_pixel(*buffer, list.palette, list.clear_color));
+	}
+	PROFILE_SCOPE("rasterize");
+	for(size_t i = 0; i < list.num_commands; ++i)
+	{
+		draw_command_render(buffer, list.commands[i], clip, list.palette);
+	}
+}
+
+void draw_list_render_clipped(Buffer* buffer, const DrawList& list, const Rect& clip)
+{
+	buffer_fill_rect(buffer, clip, draw_list_pixel(*buffer, list.palette, list.clear_color));
+	for(size_t i = 0; i < list.num_commands; ++i)
+	{
+		const DrawCommand& command = list.commands[i];
+		Rect rect = draw_command_rect(command);
+		if(rect.x0 >= clip.x1 || rect.x1 <= clip.x0 || rect.y0 >= clip.y1 || rect.y1 <= clip.y0) continue;
+		draw_command_render(buffer, command, clip, list.palette);
+	}
+}
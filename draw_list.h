@@ -0,0 +1,66 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include "buffer.h"
+
+// One sprite, glyph or solid rectangle to draw into the buffer
+struct DrawCommand
+{
+	// Row masks of the sprite, NULL for a solid rectangle
+	const uint32_t* rows;
+	uint32_t x, y;
+	uint16_t width, height;
+	uint32_t color;
+};
+
+// Everything drawn in a frame, in drawing order, recorded instead of
+// rasterized right away so that it can be compared with the previous frame
+struct DrawList
+{
+	// With a palette, the colors of the list are indices into it: an RGBA
+	// buffer gets the colors they stand for and an indexed buffer the indices.
+	// Without one they are stored in the buffer as they are
+	const Palette* palette;
+	uint32_t clear_color;
+	size_t num_commands;
+	size_t capacity;
+	DrawCommand* commands;
+};
+
+void draw_list_init(DrawList* list);
+void draw_list_free(DrawList* list);
+
+// Start a new frame cleared to clear_color, with the colors taken from palette
+void draw_list_reset(DrawList* list, uint32_t clear_color, const Palette* palette = NULL);
+
+// Value stored in the buffer for a color of a list with the palette
+inline uint32_t draw_list_pixel(const Buffer& buffer, const Palette* palette, uint32_t color)
+{
+	return (palette && buffer.format == PIXEL_RGBA)? palette->colors[color]: color;
+}
+
+// Same as the buffer_draw_* functions, recorded into the list
+void draw_list_sprite(DrawList* list, const Sprite& sprite, size_t x, size_t y, uint32_t color);
+void draw_list_text(DrawList* list, const Sprite& text_spritesheet, const char* text,
+		size_t x, size_t y, uint32_t color);
+void draw_list_number(DrawList* list, const Sprite& number_spritesheet, size_t number,
+		size_t x, size_t y, uint32_t color);
+void draw_list_hline(DrawList* list, size_t x, size_t y, size_t width, uint32_t color);
+
+// Area covered by a command
+Rect draw_command_rect(const DrawCommand& command);
+
+// Draw the part of a command that falls inside the clip rectangle, with the
+// palette of its list
+void draw_command_render(Buffer* buffer, const DrawCommand& command, const Rect& clip,
+		const Palette* palette = NULL);
+
+// Clear the buffer and draw every command of the list
+void draw_list_render(Buffer* buffer, const DrawList& list);
+
+// Clear the clip rectangle and draw the part of every command that falls inside it
+void draw_list_render_clipped(Buffer* buffer, const DrawList& list, const Rect& clip);
+
+#endif
@@ -0,0 +1,95 @@
+#include <cstring>
+#include "env_batch.h"
+#include "profiler.h"
+
+// Games per task of the thread pool, so that a task is long enough
+// to be worth handing out but a batch still splits across the threads
+#define ENV_BATCH_GRAIN 16
+
+static void env_observe(const EnvBatch& batch, const Game& game, EnvObservation* observation)
+{
+	observation->player_x = game.player.x;
+	observation->num_bullets = game.bullets.count;
+	observation->score = game.score;
+	memcpy(observation->aliens_alive, game.aliens.alive, batch.alive_words * sizeof(uint64_t));
+}
+
+void env_batch_init(EnvBatch* batch, ThreadPool* pool, const GameAssets* assets,
+		size_t num_envs, size_t max_steps)
+{
+	batch->num_envs = num_envs;
+	batch->max_steps = max_steps;
+	batch->pool = pool;
+	arena_init(&batch->arena);
+	batch->games = arena_alloc_array<Game>(&batch->arena, num_envs);
+	batch->steps = arena_alloc_array<size_t>(&batch->arena, num_envs);
+	batch->observations = arena_alloc_array<EnvObservation>(&batch->arena, num_envs);
+	const AssetFormation& formation = assets->formation;
+	batch->alive_words = (formation.columns * formation.rows + 63) / 64;
+	batch->rewards = arena_alloc_array<float>(&batch->arena, num_envs);
+	batch->done = arena_alloc_array<uint8_t>(&batch->arena, num_envs);
+	for(size_t i = 0; i < num_envs; ++i)
+	{
+		game_init(&batch->games[i], &batch->arena, assets, 224, 256);
+		batch->observations[i].aliens_alive = arena_alloc_array<uint64_t>(&batch->arena, batch->alive_words);
+	}
+	env_batch_reset(batch);
+}
+
+void env_batch_free(EnvBatch* batch)
+{
+	for(size_t i = 0; i < batch->num_envs; ++i)
+	{
+		game_free(&batch->games[i]);
+	}
+	arena_free(&batch->arena);
+	batch->num_envs = 0;
+}
+
+void env_batch_reset(EnvBatch* batch)
+{
+	for(size_t i = 0; i < batch->num_envs; ++i)
+	{
+		game_reset(&batch->games[i]);
+		batch->steps[i] = 0;
+		batch->rewards[i] = 0;
+		batch->done[i] = 0;
+		env_observe(*batch, batch->games[i], &batch->observations[i]);
+	}
+	batch->total_steps = 0;
+	batch->total_episodes = 0;
+}
+
+void env_batch_step(EnvBatch* batch, const GameInput* actions)
+{
+	size_t num_tasks = (batch->num_envs + ENV_BATCH_GRAIN - 1) / ENV_BATCH_GRAIN;
+	parallel_for(batch->pool, num_tasks, [&](size_t task)
+	{
+		PROFILE_SCOPE("env task");
+		size_t end = (task + 1) * ENV_BATCH_GRAIN;
+		if(end > batch->num_envs) end = batch->num_envs;
+		for(size_t i = task * ENV_BATCH_GRAIN; i < end; ++i)
+		{
+			Game& game = batch->games[i];
+			size_t score = game.score;
+			game_simulate(&game, actions[i]);
+			batch->rewards[i] = game.score - score;
+
+			bool done = ++batch->steps[i] >= batch->max_steps || !alien_store_num_alive(game.aliens);
+			batch->done[i] = done;
+			if(done)
+			{
+				game_reset(&game);
+				batch->steps[i] = 0;
+			}
+			env_observe(*batch, game, &batch->observations[i]);
+		}
+	});
+
+	// Counted afterwards to keep the tasks free of shared writes
+	batch->total_steps += batch->num_envs;
+	for(size_t i = 0; i < batch->num_envs; ++i)
+	{
+		batch->total_episodes += batch->done[i];
+	}
+}
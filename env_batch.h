@@ -0,0 +1,59 @@
+#ifndef ENV_BATCH_H
+#define ENV_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include "arena.h"
+#include "assets.h"
+#include "game.h"
+#include "thread_pool.h"
+
+// What an agent sees of its game after a step
+struct EnvObservation
+{
+	int16_t player_x;
+	uint16_t num_bullets;
+	uint32_t score;
+	// Bit i is set while alien i of the formation is alive, 64 aliens per
+	// word and EnvBatch::alive_words words, held by the batch
+	uint64_t* aliens_alive;
+};
+
+// N independent games stepped together, for running the game as an
+// environment for automated agents. Games are sharded across the thread
+// pool; nothing is shared between them but the read-only assets
+struct EnvBatch
+{
+	size_t num_envs;
+	// Episodes end when every alien is dead or after this many steps
+	size_t max_steps;
+	ThreadPool* pool;
+	// Holds the arrays below and the state of every game
+	Arena arena;
+	Game* games;
+	// Steps taken in the current episode of each game
+	size_t* steps;
+	// Outputs of the last step, one per game
+	EnvObservation* observations;
+	// Words of an alive mask, enough for the formation of the assets
+	size_t alive_words;
+	float* rewards;
+	uint8_t* done;
+	// Totals over all the games
+	size_t total_steps;
+	size_t total_episodes;
+};
+
+void env_batch_init(EnvBatch* batch, ThreadPool* pool, const GameAssets* assets,
+		size_t num_envs, size_t max_steps);
+void env_batch_free(EnvBatch* batch);
+
+// Start a new episode in every game and fill in the first observations
+void env_batch_reset(EnvBatch* batch);
+
+// Advance game i by one tick with actions[i]. The reward is the score
+// gained in the tick. A game whose episode ended has done set, and is
+// reset in place: its observation is already the first one of the next episode
+void env_batch_step(EnvBatch* batch, const GameInput* actions);
+
+#endif
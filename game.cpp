@@ -0,0 +1,468 @@
+#include <cstdio>
+#include <cstring>
+#include "game.h"
+#include "profiler.h"
+
+void game_init(Game* game, Arena* arena, const GameAssets* assets, size_t width, size_t height)
+{
+	game->assets = assets;
+	game->width = width;
+	game->height = height;
+	for(size_t i = 0; i < PALETTE_SIZE; ++i)
+	{
+		game->palette.colors[i] = rgb_to_uint32(0, 0, 0);
+	}
+	game->palette.colors[GAME_COLOR_BACKGROUND] = rgb_to_uint32(0, 128, 0);
+	game->palette.colors[GAME_COLOR_FOREGROUND] = rgb_to_uint32(128, 0, 0);
+	pool_init(&game->bullets);
+
+	for(size_t i=0; i<3; ++i)
+	{
+		SpriteAnimation& animation = game->alien_animation[i];
+		animation.loop = true;
+		animation.time = 0;
+		animation.frames = arena_alloc_array<const Sprite*>(arena, ASSET_MAX_ANIMATION_FRAMES);
+	}
+
+	const AssetFormation& formation = assets->formation;
+	alien_store_init(&game->aliens, arena, formation.columns * formation.rows);
+	AlienMarch& march = game->march;
+	march.columns = formation.columns;
+	march.rows = formation.rows;
+	march.column_alive = arena_alloc_array<uint32_t>(arena, march.columns);
+	march.row_alive = arena_alloc_array<uint32_t>(arena, march.rows);
+	spatial_grid_init(&game->alien_grid, arena, game->aliens.count, width, height,
+			GAME_GRID_CELL_SIZE, GAME_GRID_CELL_SIZE);
+
+	game->hud = arena_alloc_array<GameHud>(arena, 1);
+	text_cache_init(&game->hud->cache, arena);
+	game_set_assets(game, assets);
+
+	game_reset(game);
+}
+
+bool game_assets_valid(const GameAssets& assets)
+{
+	const AssetFormation& formation = assets.formation;
+	if(formation.columns * formation.rows == 0 || formation.rows > ASSET_MAX_FORMATION_ROWS) return false;
+	for(size_t yi = 0; yi < formation.rows; ++yi)
+	{
+		if(formation.row_types[yi] < ALIEN_TYPE_A || formation.row_types[yi] > ALIEN_TYPE_C) return false;
+	}
+	for(size_t i = 0; i < 3; ++i)
+	{
+		const AssetAnimation& animation = assets.alien_animations[i];
+		if(animation.num_frames == 0 || animation.num_frames > ASSET_MAX_ANIMATION_FRAMES) return false;
+		if(animation.frame_duration == 0) return false;
+		for(size_t f = 0; f < animation.num_frames; ++f)
+		{
+			if(animation.frames[f] >= 6) return false;
+		}
+	}
+	// The collision grid finds aliens by the cell of their bottom left corner
+	for(size_t i = 0; i < 6; ++i)
+	{
+		const Sprite& sprite = assets.alien_sprites[i];
+		if(sprite.width > GAME_GRID_CELL_SIZE || sprite.height > GAME_GRID_CELL_SIZE) return false;
+	}
+	const Sprite& death = assets.alien_death_sprite;
+	return death.width <= GAME_GRID_CELL_SIZE && death.height <= GAME_GRID_CELL_SIZE;
+}
+
+bool game_assets_compatible(const Game& game, const GameAssets& assets)
+{
+	const AssetFormation& formation = assets.formation;
+	return game_assets_valid(assets) && formation.columns == game.march.columns && formation.rows == game.march.rows;
+}
+
+void game_set_assets(Game* game, const GameAssets* assets)
+{
+	game->assets = assets;
+	for(size_t i = 0; i < 3; ++i)
+	{
+		const AssetAnimation& source = assets->alien_animations[i];
+		SpriteAnimation& animation = game->alien_animation[i];
+		animation.num_frames = source.num_frames;
+		animation.frame_duration = source.frame_duration;
+		for(size_t f = 0; f < source.num_frames; ++f)
+		{
+			animation.frames[f] = &assets->alien_sprites[source.frames[f]];
+		}
+		animation.time %= animation.num_frames * animation.frame_duration;
+	}
+
+	// The HUD strings are looked up again with the new font, which may sit
+	// where an earlier one did
+	GameHud& hud = *game->hud;
+	text_cache_forget(&hud.cache, assets->text_spritesheet);
+	hud.score_label = text_cache_get(&hud.cache, assets->text_spritesheet, "SCORE");
+	hud.score_text = hud.credit_text = NULL;
+	// Values no game shows, so the next draw formats both
+	hud.score = hud.credits = (size_t)-1;
+}
+
+void game_reset(Game* game)
+{
+	const GameAssets& assets = *game->assets;
+
+	game->player.x = 112 - 5;
+	game->player.y = 32;
+
+	game->player.life = 3;
+
+	game->score = 0;
+	game->credits = 0;
+
+	pool_clear(&game->bullets);
+
+	for(size_t i=0; i<3; ++i)
+	{
+		game->alien_animation[i].time = 0;
+	}
+
+	// Lay the aliens out as the formation of the assets says
+	AlienStore& aliens = game->aliens;
+	alien_store_reset(&aliens);
+	const AssetFormation& formation = assets.formation;
+	for(size_t yi = 0; yi < formation.rows; ++yi)
+	{
+		for(size_t xi = 0; xi < formation.columns; ++xi)
+		{
+			size_t ai = yi * formation.columns + xi;
+			aliens.type[ai] = formation.row_types[yi];
+
+			const Sprite& sprite = *game->alien_animation[aliens.type[ai] - 1].frames[0];
+
+			aliens.x[ai] = formation.dx * xi + formation.x + (assets.alien_death_sprite.width - sprite.width)/2;
+			aliens.y[ai] = formation.dy * yi + formation.y;
+		}
+	}
+
+	for(size_t ai = 0; ai < aliens.count; ++ai)
+	{
+		spatial_grid_remove(&game->alien_grid, ai);
+		spatial_grid_insert(&game->alien_grid, ai, aliens.x[ai], aliens.y[ai]);
+	}
+
+	// The formation starts where it was laid out, heading right
+	AlienMarch& march = game->march;
+	march.origin_x = formation.x;
+	march.origin_y = formation.y;
+	march.dx = formation.dx;
+	march.dy = formation.dy;
+	march.cell_width = assets.alien_death_sprite.width;
+	march.x = march.y = 0;
+	march.dir = 1;
+	march.countdown = GAME_MARCH_TICKS;
+	game_recount_aliens(game);
+}
+
+void game_recount_aliens(Game* game)
+{
+	AlienMarch& march = game->march;
+	const AlienStore& aliens = game->aliens;
+	memset(march.column_alive, 0, march.columns * sizeof(uint32_t));
+	memset(march.row_alive, 0, march.rows * sizeof(uint32_t));
+	march.num_alive = 0;
+	for(size_t yi = 0; yi < march.rows; ++yi)
+	{
+		for(size_t xi = 0; xi < march.columns; ++xi)
+		{
+			if(!alien_store_alive(aliens, yi * march.columns + xi)) continue;
+			++march.column_alive[xi];
+			++march.row_alive[yi];
+			++march.num_alive;
+		}
+	}
+	march.left = march.bottom = 0;
+	march.right = march.columns - 1;
+	if(!march.num_alive) return;
+	while(!march.column_alive[march.left]) ++march.left;
+	while(!march.column_alive[march.right]) --march.right;
+	while(!march.row_alive[march.bottom]) ++march.bottom;
+}
+
+// Count alien ai out of its column and row, and move the edges of the block
+// past the columns and rows left empty. The edges only ever move inwards, so
+// over a whole game they cost no more than the number of columns and rows
+static void alien_march_kill(AlienMarch* march, size_t ai)
+{
+	size_t column = ai % march->columns, row = ai / march->columns;
+	--march->column_alive[column];
+	--march->row_alive[row];
+	if(!--march->num_alive) return;
+	while(!march->column_alive[march->left]) ++march->left;
+	while(!march->column_alive[march->right]) --march->right;
+	while(!march->row_alive[march->bottom]) ++march->bottom;
+}
+
+// Step the block sideways when it is due, or drop it and turn when the step
+// would take its outer columns off the screen. It never drops onto the player
+static void alien_march_step(Game* game, const Sprite& player_sprite)
+{
+	AlienMarch& march = game->march;
+	if(!march.num_alive) return;
+	if(march.countdown > 1)
+	{
+		--march.countdown;
+		return;
+	}
+	// Full speed with a single alien left
+	march.countdown = GAME_MARCH_TICKS * march.num_alive / game->aliens.count;
+	if(march.countdown == 0) march.countdown = 1;
+
+	int32_t left = march.origin_x + (int32_t)march.left * march.dx + march.x;
+	int32_t right = march.origin_x + (int32_t)march.right * march.dx + march.cell_width + march.x;
+	int32_t step = march.dir * GAME_MARCH_STEP;
+	if(left + step < 0 || right + step > (int32_t)game->width)
+	{
+		int32_t bottom = march.origin_y + (int32_t)march.bottom * march.dy + march.y;
+		if(bottom - GAME_MARCH_DROP >= (int32_t)(game->player.y + player_sprite.height)) march.y -= GAME_MARCH_DROP;
+		march.dir = -march.dir;
+	}
+	else
+	{
+		march.x += step;
+	}
+}
+
+void game_free(Game* game)
+{
+	pool_free(&game->bullets);
+}
+
+void game_draw(const Game& game, DrawList* list)
+{
+	PROFILE_SCOPE("draw list");
+	const GameAssets& assets = *game.assets;
+	draw_list_reset(list, GAME_COLOR_BACKGROUND, &game.palette);
+	{
+		PROFILE_SCOPE("hud");
+		GameHud& hud = *game.hud;
+		if(hud.credits != game.credits)
+		{
+			char credit_text[16];
+			snprintf(credit_text, sizeof(credit_text), "CREDIT %02lu", game.credits);
+			hud.credit_text = text_cache_get(&hud.cache, assets.text_spritesheet, credit_text);
+			hud.credits = game.credits;
+		}
+		if(hud.score != game.score)
+		{
+			// The digits of the number spritesheet are those of the text spritesheet
+			char score_text[24];
+			snprintf(score_text, sizeof(score_text), "%lu", game.score);
+			hud.score_text = text_cache_get(&hud.cache, assets.text_spritesheet, score_text);
+			hud.score = game.score;
+		}
+
+		uint32_t color = GAME_COLOR_FOREGROUND;
+		text_cache_draw(&hud.cache, list, hud.score_label,
+				4, game.height - assets.text_spritesheet.height - 7, color);
+		text_cache_draw(&hud.cache, list, hud.credit_text, 164, 7, color);
+		text_cache_draw(&hud.cache, list, hud.score_text,
+				4 + 2 * assets.number_spritesheet.width, game.height - 2 * assets.number_spritesheet.height - 12,
+				color);
+		draw_list_hline(list, 0, 16, game.width, color);
+	}
+
+	// Draw the aliens, and the dead ones while their death counter is bigger than 0.
+	// The arrays are copied to locals so they are not reloaded after every call
+	// They are drawn where the march has taken the block. A dying alien in a
+	// column the block no longer counts can be past the edge, it is skipped
+	const AlienStore& aliens = game.aliens;
+	const int16_t* alien_x = aliens.x;
+	const int16_t* alien_y = aliens.y;
+	const uint8_t* alien_type = aliens.type;
+	const uint8_t* death_counter = aliens.death_counter;
+	int32_t march_x = game.march.x, march_y = game.march.y;
+	for(size_t ai = 0; ai < aliens.count; ++ai)
+	{
+		int32_t x = alien_x[ai] + march_x, y = alien_y[ai] + march_y;
+		if(alien_store_alive(aliens, ai))
+		{
+			const SpriteAnimation& animation = game.alien_animation[alien_type[ai] - 1];
+			size_t current_frame = animation.time / animation.frame_duration;
+			const Sprite& sprite = *animation.frames[current_frame];
+			draw_list_sprite(list, sprite, x, y, GAME_COLOR_FOREGROUND);
+		}
+		else if(death_counter[ai] && x >= 0 && y >= 0)
+		{
+			draw_list_sprite(list, assets.alien_death_sprite, x, y, GAME_COLOR_FOREGROUND);
+		}
+	}
+
+	// Draw the bullets
+	pool_for_each(game.bullets, [&](PoolHandle, const Bullet& bullet)
+	{
+		const Sprite& sprite = assets.bullet_sprite;
+		draw_list_sprite(list, sprite, bullet.x, bullet.y, GAME_COLOR_FOREGROUND);
+	});
+
+	draw_list_sprite(list, assets.player_sprite, game.player.x, game.player.y, GAME_COLOR_FOREGROUND);
+}
+
+void game_simulate(Game* game, const GameInput& input)
+{
+	PROFILE_SCOPE("simulate");
+	const GameAssets& assets = *game->assets;
+	const Sprite& bullet_sprite = assets.bullet_sprite;
+	const Sprite& player_sprite = assets.player_sprite;
+
+	// Update animations
+	for(size_t i = 0; i < 3; ++i)
+	{
+		++game->alien_animation[i].time;
+		if(game->alien_animation[i].time == game->alien_animation[i].num_frames * game->alien_animation[i].frame_duration)
+		{
+			game->alien_animation[i].time = 0;
+		}
+	}
+
+	// Simulate aliens. Decrease death counter every frame
+	AlienStore& aliens = game->aliens;
+	alien_store_update_deaths(&aliens);
+
+	// Current animation frame of each alien type
+	const Sprite* alien_frames[3];
+	for(size_t i = 0; i < 3; ++i)
+	{
+		const SpriteAnimation& animation = game->alien_animation[i];
+		alien_frames[i] = animation.frames[animation.time / animation.frame_duration];
+	}
+
+	// Simulate bullets. Add dir, and remove projectiles that move out of game area
+	AlienMarch& march = game->march;
+	pool_for_each(&game->bullets, [&](PoolHandle handle, Bullet& bullet)
+	{
+		bullet.y += bullet.dir;
+		if(bullet.y >= (int)game->height ||
+				bullet.y < (int)bullet_sprite.height)
+		{
+			pool_remove(&game->bullets, handle);
+			return;
+		}
+
+		// Check if a bullet hits an alien that is alive. Only the aliens filed
+		// near the bullet in the grid are tested, and the lowest index wins
+		// as it would when going through all the aliens in order. A hit needs
+		// the bullet to touch a pixel of the alien, not just its bounding box.
+		// The grid is looked up with the bullet moved into the layout, where
+		// no alien is left of or below 0
+		size_t bullet_x = bullet.x, bullet_y = bullet.y;
+		int32_t layout_x = bullet.x - march.x, layout_y = bullet.y - march.y;
+		if(layout_x + (int32_t)bullet_sprite.width <= 0 || layout_y + (int32_t)bullet_sprite.height <= 0) return;
+		Rect area = {(size_t)(layout_x > 0? layout_x: 0), (size_t)(layout_y > 0? layout_y: 0),
+				(size_t)layout_x + bullet_sprite.width, (size_t)layout_y + bullet_sprite.height};
+		size_t hit = aliens.count;
+		spatial_grid_query(game->alien_grid, area, [&](size_t ai)
+		{
+			if(ai < hit && sprite_pixel_overlap_check(
+					bullet_sprite, bullet_x, bullet_y,
+					*alien_frames[aliens.type[ai] - 1], aliens.x[ai] + march.x, aliens.y[ai] + march.y))
+			{
+				hit = ai;
+			}
+		});
+
+		if(hit == aliens.count) return;
+
+		const Sprite& alien_sprite = *alien_frames[aliens.type[hit] - 1];
+		// Based on the alien type, add score between 10 - 40 points
+		game->score += 10 * (4 - aliens.type[hit]);
+		alien_store_kill(&aliens, hit, 10);
+		alien_march_kill(&march, hit);
+		spatial_grid_remove(&game->alien_grid, hit);
+		// NOTE: Hack to recenter death sprite
+		aliens.x[hit] -= (assets.alien_death_sprite.width - alien_sprite.width)/2;
+		pool_remove(&game->bullets, handle);
+	});
+
+	alien_march_step(game, player_sprite);
+
+	// Simulate player
+	// variable that controls player direction of movement
+	int player_move_dir = input.move_dir;
+
+	if(player_move_dir != 0){
+		// Basic collision detection of player sprite with the wall
+		if(game->player.x + player_sprite.width + player_move_dir >= game->width -1)
+		{
+			// can't go past boundary
+			game->player.x = game->width - player_sprite.width;
+		}
+		else if((int)game->player.x + player_move_dir <= 0)
+		{
+			game->player.x = 0;
+		}
+		else game->player.x += player_move_dir;
+	}
+
+	// Process events
+	if(input.fire_pressed)
+	{
+		Bullet bullet;
+		bullet.x = game->player.x + player_sprite.width / 2;
+		bullet.y = game->player.y + player_sprite.height;
+		bullet.dir = 2;
+		pool_add(&game->bullets, bullet);
+	}
+}
+
+// FNV-1a, fed field by field so padding bytes never reach the hash
+static void hash_bytes(uint64_t* hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for(size_t i = 0; i < size; ++i)
+	{
+		*hash = (*hash ^ bytes[i]) * 1099511628211ull;
+	}
+}
+
+static void hash_value(uint64_t* hash, uint64_t value)
+{
+	hash_bytes(hash, &value, sizeof(value));
+}
+
+uint64_t game_hash(const Game& game)
+{
+	uint64_t hash = 14695981039346656037ull;
+	hash_value(&hash, game.player.x);
+	hash_value(&hash, game.player.y);
+	hash_value(&hash, game.player.life);
+	hash_value(&hash, game.score);
+	hash_value(&hash, game.credits);
+	for(size_t i = 0; i < 3; ++i)
+	{
+		hash_value(&hash, game.alien_animation[i].time);
+	}
+
+	const AlienMarch& march = game.march;
+	hash_value(&hash, march.x);
+	hash_value(&hash, march.y);
+	hash_value(&hash, march.dir);
+	hash_value(&hash, march.countdown);
+
+	const AlienStore& aliens = game.aliens;
+	hash_bytes(&hash, aliens.x, aliens.count * sizeof(int16_t));
+	hash_bytes(&hash, aliens.y, aliens.count * sizeof(int16_t));
+	hash_bytes(&hash, aliens.type, aliens.count);
+	hash_bytes(&hash, aliens.death_counter, aliens.count);
+	hash_bytes(&hash, aliens.alive, (aliens.count + 63) / 64 * sizeof(uint64_t));
+
+	hash_value(&hash, game.bullets.count);
+	pool_for_each(game.bullets, [&](PoolHandle handle, const Bullet& bullet)
+	{
+		hash_value(&hash, handle.index);
+		hash_value(&hash, bullet.x);
+		hash_value(&hash, bullet.y);
+		hash_value(&hash, bullet.dir);
+	});
+	return hash;
+}
+
+void game_step(Game* game, DrawList* list, Buffer* buffer, const GameInput& input)
+{
+	game_draw(*game, list);
+	draw_list_render(buffer, *list);
+	game_simulate(game, input);
+}
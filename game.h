@@ -0,0 +1,171 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include "buffer.h"
+#include "assets.h"
+#include "draw_list.h"
+#include "spatial_grid.h"
+#include "alien_store.h"
+#include "pool.h"
+#include "arena.h"
+#include "text_cache.h"
+
+enum AlienType: uint8_t
+{
+	ALIEN_TYPE_A = 1,
+	ALIEN_TYPE_B = 2,
+	ALIEN_TYPE_C = 3
+};
+
+// Palette indices of the colors the game draws with
+enum GameColor: uint8_t
+{
+	GAME_COLOR_BACKGROUND = 0,
+	GAME_COLOR_FOREGROUND = 1
+};
+
+// Position x,y in pixels from the bottom left corner of window
+// Number of lvies of the player
+struct Player
+{
+	size_t x,y;
+	size_t life;
+};
+
+// For the projectiles
+// sign of dir indicates the direction of travel
+struct Bullet
+{
+	int16_t x, y;
+	int16_t dir;
+};
+
+// Cell size of the alien collision grid, at least the size of the largest alien sprite
+#define GAME_GRID_CELL_SIZE 16
+
+// The formation steps GAME_MARCH_STEP pixels sideways every GAME_MARCH_TICKS
+// ticks while it is full, and more often as aliens die, down to every tick.
+// At the edge of the screen it drops GAME_MARCH_DROP pixels instead and turns
+#define GAME_MARCH_TICKS 32
+#define GAME_MARCH_STEP 2
+#define GAME_MARCH_DROP 8
+
+// The aliens march as one block: their positions in the store are those of
+// the formation as laid out, and where the block has moved since is kept
+// here. The aliens alive in each column and row are counted as they die, so
+// the edges of the block are known at every step without going through the
+// aliens, and the collision grid never has to refile them
+struct AlienMarch
+{
+	size_t columns, rows;
+	// Layout of the formation: left and bottom of its first cell, distance
+	// between cells and width of a cell
+	int32_t origin_x, origin_y;
+	int32_t dx, dy;
+	int32_t cell_width;
+	// Offset of the block from its layout, and 1 or -1 for the direction of the next step
+	int32_t x, y;
+	int32_t dir;
+	// Ticks until the next step
+	size_t countdown;
+	size_t num_alive;
+	uint32_t* column_alive;
+	uint32_t* row_alive;
+	// Left and right most columns and bottom row with an alien alive,
+	// meaningless once num_alive is 0
+	size_t left, right, bottom;
+};
+
+struct SpriteAnimation
+{
+	// if we should loop over animation or play it only once
+	bool loop;
+	size_t num_frames;
+	size_t frame_duration;
+	// time between successive frames
+	size_t time;
+	const Sprite** frames;
+};
+
+// Input sampled once per frame, either from the keyboard or from a script
+struct GameInput
+{
+	int move_dir;
+	bool fire_pressed;
+};
+
+// HUD strings as last drawn. They are formatted and looked up in the
+// cache again only when the values they show change
+struct GameHud
+{
+	TextCache cache;
+	size_t score, credits;
+	const CachedText* score_label;
+	const CachedText* score_text;
+	const CachedText* credit_text;
+};
+
+// Height and width of the game in pixels,
+// along with everything that changes while playing
+struct Game
+{
+	size_t width, height;
+	AlienStore aliens;
+	// Broad phase for bullet collisions, holds the aliens that are alive
+	// at their positions in the layout
+	SpatialGrid alien_grid;
+	AlienMarch march;
+	Player player;
+	Pool<Bullet> bullets;
+	SpriteAnimation alien_animation[3];
+	size_t score;
+	size_t credits;
+	const GameAssets* assets;
+	// Colors of the GameColor indices. It only changes the picture, so it is
+	// neither part of snapshots nor of the hash
+	Palette palette;
+	// Drawing state, behind a pointer so that game_draw can keep it up to date
+	GameHud* hud;
+};
+
+// The state of the game is allocated from the arena, which has to outlive
+// the game, except for the bullets which game_free releases. The assets
+// must be valid, see game_assets_valid
+void game_init(Game* game, Arena* arena, const GameAssets* assets, size_t width, size_t height);
+void game_free(Game* game);
+
+// Start a new game in place, without allocating
+void game_reset(Game* game);
+
+// Whether a game can be played with the assets: the formation and
+// animations are well formed and the alien sprites fit the collision grid
+bool game_assets_valid(const GameAssets& assets);
+
+// Whether the game can switch to the assets: they are valid and the
+// formation has as many columns and rows as the game was started with
+bool game_assets_compatible(const Game& game, const GameAssets& assets);
+
+// Draw and animate with the assets from now on, which must be compatible.
+// Positions only change with the formation at the next game_reset
+void game_set_assets(Game* game, const GameAssets* assets);
+
+// Count the aliens alive per column and row of the formation again, after
+// the alive bits were replaced wholesale
+void game_recount_aliens(Game* game);
+
+// Record the current state of the game as a list of draw commands
+void game_draw(const Game& game, DrawList* list);
+
+// Advance the simulation by one frame
+void game_simulate(Game* game, const GameInput& input);
+
+// Hash of everything that affects how the game plays out from here,
+// to detect when two runs diverge
+uint64_t game_hash(const Game& game);
+
+// The per-frame work of the game loop: draw the current state then simulate
+void game_step(Game* game, DrawList* list, Buffer* buffer, const GameInput& input);
+
+#endif
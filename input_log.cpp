@@ -0,0 +1,165 @@
+#include <cstring>
+#include "input_log.h"
+
+#define INPUT_LOG_RUN 0x80
+#define INPUT_LOG_FIRE 0x01
+#define INPUT_LOG_MOVE 0x02
+#define INPUT_LOG_HASH 0x04
+// Longest run one byte holds
+#define INPUT_LOG_MAX_RUN 128
+
+static void put_byte(InputLog* log, uint8_t byte)
+{
+	fputc(byte, log->file);
+	++log->bytes;
+}
+
+static void put_uint(InputLog* log, uint32_t value, size_t size)
+{
+	for(size_t i = 0; i < size; ++i)
+	{
+		put_byte(log, (value >> (8 * i)) & 0xff);
+	}
+}
+
+static bool get_uint(InputLog* log, uint32_t* value, size_t size)
+{
+	*value = 0;
+	for(size_t i = 0; i < size; ++i)
+	{
+		int byte = fgetc(log->file);
+		if(byte == EOF) return false;
+		*value |= (uint32_t)byte << (8 * i);
+		++log->bytes;
+	}
+	return true;
+}
+
+static void flush_run(InputLog* log)
+{
+	if(!log->run) return;
+	put_byte(log, INPUT_LOG_RUN | (log->run - 1));
+	log->run = 0;
+}
+
+bool input_log_create(InputLog* log, const char* path, uint32_t hash_interval,
+		double tick_rate, size_t width, size_t height)
+{
+	log->file = fopen(path, "wb");
+	if(!log->file) return false;
+	log->writing = true;
+	log->hash_interval = hash_interval;
+	log->tick_rate = tick_rate;
+	log->width = width;
+	log->height = height;
+	log->move_dir = 0;
+	log->ticks = 0;
+	log->run = 0;
+	log->bytes = 0;
+
+	fwrite("SIRL", 1, 4, log->file);
+	log->bytes += 4;
+	put_uint(log, INPUT_LOG_VERSION, 2);
+	put_uint(log, hash_interval, 4);
+	put_uint(log, (uint32_t)(tick_rate * 1000 + 0.5), 4);
+	put_uint(log, width, 2);
+	put_uint(log, height, 2);
+	return true;
+}
+
+bool input_log_open(InputLog* log, const char* path)
+{
+	log->file = fopen(path, "rb");
+	if(!log->file) return false;
+	log->writing = false;
+	log->move_dir = 0;
+	log->ticks = 0;
+	log->run = 0;
+	log->bytes = 0;
+
+	char magic[4];
+	uint32_t version, hash_interval, tick_rate, width, height;
+	if(fread(magic, 1, 4, log->file) != 4 || memcmp(magic, "SIRL", 4) != 0 ||
+			!get_uint(log, &version, 2) || version != INPUT_LOG_VERSION ||
+			!get_uint(log, &hash_interval, 4) || !get_uint(log, &tick_rate, 4) ||
+			!get_uint(log, &width, 2) || !get_uint(log, &height, 2) || width == 0 || height == 0)
+	{
+		fclose(log->file);
+		log->file = NULL;
+		return false;
+	}
+	log->bytes += 4;
+	log->hash_interval = hash_interval;
+	log->tick_rate = tick_rate / 1000.0;
+	log->width = width;
+	log->height = height;
+	return true;
+}
+
+void input_log_close(InputLog* log)
+{
+	if(!log->file) return;
+	if(log->writing) flush_run(log);
+	fclose(log->file);
+	log->file = NULL;
+}
+
+void input_log_write(InputLog* log, const GameInput& input, const Game& game)
+{
+	++log->ticks;
+	bool hash = log->hash_interval && log->ticks % log->hash_interval == 0;
+	bool move = input.move_dir != log->move_dir;
+	if(!input.fire_pressed && !move && !hash)
+	{
+		if(++log->run == INPUT_LOG_MAX_RUN) flush_run(log);
+		return;
+	}
+
+	flush_run(log);
+	uint8_t flags = 0;
+	if(input.fire_pressed) flags |= INPUT_LOG_FIRE;
+	if(move) flags |= INPUT_LOG_MOVE;
+	if(hash) flags |= INPUT_LOG_HASH;
+	put_byte(log, flags);
+	if(move)
+	{
+		put_byte(log, (uint8_t)(int8_t)input.move_dir);
+		log->move_dir = input.move_dir;
+	}
+	if(hash) put_uint(log, input_log_hash(game_hash(game)), 4);
+}
+
+bool input_log_read(InputLog* log, GameInput* input, bool* has_hash, uint32_t* hash)
+{
+	input->fire_pressed = false;
+	*has_hash = false;
+	if(!log->run)
+	{
+		uint32_t flags;
+		if(!get_uint(log, &flags, 1)) return false;
+		if(flags & INPUT_LOG_RUN)
+		{
+			log->run = (flags & ~INPUT_LOG_RUN) + 1;
+		}
+		else
+		{
+			input->fire_pressed = flags & INPUT_LOG_FIRE;
+			uint32_t value;
+			if(flags & INPUT_LOG_MOVE)
+			{
+				if(!get_uint(log, &value, 1)) return false;
+				log->move_dir = (int8_t)value;
+			}
+			if(flags & INPUT_LOG_HASH)
+			{
+				if(!get_uint(log, hash, 4)) return false;
+				*has_hash = true;
+			}
+		}
+	}
+	if(log->run) --log->run;
+
+	input->move_dir = log->move_dir;
+	++log->ticks;
+	return true;
+}
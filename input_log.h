@@ -0,0 +1,58 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include "game.h"
+
+#define INPUT_LOG_VERSION 1
+
+// Binary log of the input of every simulation tick, to replay a session.
+// The header is the magic "SIRL", then the version (uint16), hash interval
+// (uint32), tick rate in millihertz (uint32), width and height (uint16),
+// all little-endian. Then each tick is a flag byte followed by what changed:
+//   1xxxxxxx          run of xxxxxxx + 1 ticks without fire, move or hash
+//   0xxxxHMF          F: fire pressed, M: move_dir changed (int8 follows),
+//                     H: folded state hash follows (uint32, little-endian)
+// Every hash_interval ticks the hash of the game state after the tick is
+// stored, so that a replay can tell exactly where it diverged
+struct InputLog
+{
+	FILE* file;
+	bool writing;
+	uint32_t hash_interval;
+	double tick_rate;
+	uint16_t width, height;
+	// move_dir as of the last tick written or read
+	int move_dir;
+	// Ticks written or read
+	size_t ticks;
+	// Ticks of the current run, not yet written or left to read
+	size_t run;
+	size_t bytes;
+};
+
+// Create a log and write its header. Returns false if the file cannot be created
+bool input_log_create(InputLog* log, const char* path, uint32_t hash_interval,
+		double tick_rate, size_t width, size_t height);
+
+// Open a log and read its header. Returns false if the file cannot be read or is not a log
+bool input_log_open(InputLog* log, const char* path);
+
+void input_log_close(InputLog* log);
+
+// Record the input of a tick, and the hash of the state it led to when due
+void input_log_write(InputLog* log, const GameInput& input, const Game& game);
+
+// Next tick of the log. has_hash is set if the log holds a state hash for
+// the tick. Returns false at the end of the log
+bool input_log_read(InputLog* log, GameInput* input, bool* has_hash, uint32_t* hash);
+
+// The part of a state hash that the log keeps
+inline uint32_t input_log_hash(uint64_t state_hash)
+{
+	return (uint32_t)(state_hash ^ (state_hash >> 32));
+}
+
+#endif
@@ -0,0 +1,80 @@
+#include <cstdio>
+#include "input_queue.h"
+
+void input_queue_init(InputQueue* queue)
+{
+	queue->head.store(0, std::memory_order_relaxed);
+	queue->tail.store(0, std::memory_order_relaxed);
+}
+
+bool input_queue_push(InputQueue* queue, const InputEvent& event)
+{
+	size_t head = queue->head.load(std::memory_order_relaxed);
+	if(head - queue->tail.load(std::memory_order_acquire) == INPUT_QUEUE_SIZE) return false;
+	queue->events[head % INPUT_QUEUE_SIZE] = event;
+	queue->head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+const InputEvent* input_queue_peek(InputQueue* queue)
+{
+	size_t tail = queue->tail.load(std::memory_order_relaxed);
+	if(tail == queue->head.load(std::memory_order_acquire)) return NULL;
+	return &queue->events[tail % INPUT_QUEUE_SIZE];
+}
+
+void input_queue_pop(InputQueue* queue)
+{
+	size_t tail = queue->tail.load(std::memory_order_relaxed);
+	queue->tail.store(tail + 1, std::memory_order_release);
+}
+
+void input_state_init(InputState* state)
+{
+	state->left = state->right = false;
+	state->fires = 0;
+}
+
+GameInput input_state_tick(InputState* state, InputQueue* queue, uint64_t tick_end_ns,
+		uint64_t now_ns, InputLatency* latency)
+{
+	// Fire on the press rather than the release, a press and a release
+	// within one tick still move the player for that tick
+	bool tapped_left = false, tapped_right = false;
+	const InputEvent* event;
+	while((event = input_queue_peek(queue)) && event->time_ns < tick_end_ns)
+	{
+		switch(event->key)
+		{
+			case INPUT_KEY_LEFT:
+				state->left = event->pressed;
+				tapped_left |= event->pressed;
+				break;
+			case INPUT_KEY_RIGHT:
+				state->right = event->pressed;
+				tapped_right |= event->pressed;
+				break;
+			case INPUT_KEY_FIRE:
+				if(event->pressed) ++state->fires;
+				break;
+		}
+		uint64_t delay = now_ns > event->time_ns? now_ns - event->time_ns: 0;
+		++latency->events;
+		latency->sum_ns += delay;
+		if(delay > latency->max_ns) latency->max_ns = delay;
+		input_queue_pop(queue);
+	}
+
+	GameInput input;
+	input.move_dir = (state->right || tapped_right) - (state->left || tapped_left);
+	input.fire_pressed = state->fires > 0;
+	if(state->fires) --state->fires;
+	return input;
+}
+
+void input_latency_print(const InputLatency& latency)
+{
+	if(latency.events == 0) return;
+	printf("Input latency: %lu events, %.2f ms mean, %.2f ms max from key to tick\n",
+			latency.events, latency.sum_ns / 1e6 / latency.events, latency.max_ns / 1e6);
+}
@@ -0,0 +1,73 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "game.h"
+
+// Events in flight at most, a power of two
+#define INPUT_QUEUE_SIZE 256
+
+enum InputKey: uint8_t
+{
+	INPUT_KEY_LEFT,
+	INPUT_KEY_RIGHT,
+	INPUT_KEY_FIRE
+};
+
+// A key going down or up, stamped with time_ns() when the window reported it
+struct InputEvent
+{
+	uint64_t time_ns;
+	InputKey key;
+	bool pressed;
+};
+
+// Lock-free ring of events from one producer (the window callbacks) to one
+// consumer (the simulation). Each side only writes its own index, on its
+// own cache line, and publishes it with release ordering once the slot it
+// covers is written or read
+struct InputQueue
+{
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+	alignas(64) InputEvent events[INPUT_QUEUE_SIZE];
+};
+
+void input_queue_init(InputQueue* queue);
+
+// Producer side. Returns false and drops the event if the queue is full
+bool input_queue_push(InputQueue* queue, const InputEvent& event);
+
+// Consumer side: the oldest event, or NULL if the queue is empty. It stays
+// in the queue until input_queue_pop
+const InputEvent* input_queue_peek(InputQueue* queue);
+void input_queue_pop(InputQueue* queue);
+
+// Time from an event being stamped to the tick that applied it
+struct InputLatency
+{
+	size_t events;
+	uint64_t sum_ns;
+	uint64_t max_ns;
+};
+
+// Keys as seen by the simulation, advanced one tick at a time
+struct InputState
+{
+	bool left, right;
+	// Presses not turned into shots yet, one is fired per tick
+	size_t fires;
+};
+
+void input_state_init(InputState* state);
+
+// Apply the events stamped before tick_end_ns and return the input of that
+// tick. now_ns is the time the tick is simulated, for the latency
+GameInput input_state_tick(InputState* state, InputQueue* queue, uint64_t tick_end_ns,
+		uint64_t now_ns, InputLatency* latency);
+
+void input_latency_print(const InputLatency& latency);
+
+#endif
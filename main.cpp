@@ -1,103 +1,56 @@
 #include <cstdio>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "arena.h"
+#include "asset_pack.h"
+#include "capture.h"
+#include "alloc_counter.h"
+#include "buffer.h"
+#include "assets.h"
+#include "game.h"
+#include "simd.h"
+#include "draw_list.h"
+#include "dirty_rect.h"
+#include "upload.h"
+#include "timing.h"
+#include "thread_pool.h"
+#include "tile_renderer.h"
+#include "input_log.h"
+#include "input_queue.h"
+#include "sim_thread.h"
+#include "profiler.h"
 
 bool game_running = false;
-int move_dir = 0;
-bool fire_pressed = 0;
-
-// Buffer represents pixels on the screen
-struct Buffer
-{
-	size_t width, height;
-	// Using uint32_t allows to store 4 8-bit color values for each pixel
-	uint32_t* data;
-};
-
-// A blob of heap-allocated data, along with width and height of the sprite
-// Sprite represented as a bitmap -- each pixel represented by a single bit 1 == on
-struct Sprite
-{
-	size_t width, height;
-	uint8_t* data;
-};
-
-// Position x,y in pixels from the bottom left corner of window
-struct Alien 
-{
-	size_t x,y;
-	uint8_t type;
-};
-
-enum AlienType: uint8_t
-{
-	ALIEN_DEAD = 0,
-	ALIEN_TYPE_A = 1,
-	ALIEN_TYPE_B = 2,
-	ALIEN_TYPE_C = 3
-};
-
-// Position x,y in pixels from the bottom left corner of window
-// Number of lvies of the player
-struct Player
-{
-	size_t x,y;
-	size_t life;
-};
-
-// For the projectiles
-// sign of dir indicates the direction of travel
-struct Bullet
-{
-	size_t x, y;
-	int dir;
-};
-
-#define GAME_MAX_BULLETS 128
-
-// Height and width of the game in pixels,
-struct Game 
-{
-	size_t width, height;
-	size_t num_aliens;
-	size_t num_bullets;
-	Alien* aliens;
-	Player player;
-	Bullet bullets[GAME_MAX_BULLETS];
-};
-
-struct SpriteAnimation
-{
-	// if we should loop over animation or play it only once
-	bool loop;
-	size_t num_frames;
-	size_t frame_duration;
-	// time between successive frames
-	size_t time;
-	Sprite** frames;
-};
+// Key presses and releases on their way from the window to the simulation
+InputQueue input_queue;
 
 // Callbacks for different keys
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	if(action == GLFW_REPEAT) return;
+	InputEvent event;
+	event.time_ns = time_ns();
+	event.pressed = action == GLFW_PRESS;
 	switch(key) {
 		case GLFW_KEY_ESCAPE:
 			if(action == GLFW_PRESS) game_running = false;
-			break;
+			return;
 		case GLFW_KEY_RIGHT:
-			if(action == GLFW_PRESS) move_dir += 1;
-			else if(action == GLFW_RELEASE) move_dir -= 1;
+			event.key = INPUT_KEY_RIGHT;
 			break;
 		case GLFW_KEY_LEFT:
-			if(action == GLFW_PRESS) move_dir -= 1;
-			else if(action == GLFW_RELEASE) move_dir += 1;
+			event.key = INPUT_KEY_LEFT;
 			break;
 		case GLFW_KEY_SPACE:
-			if(action == GLFW_RELEASE) fire_pressed = true;
+			event.key = INPUT_KEY_FIRE;
 			break;
 		default:
-			break;
+			return;
 	}
+	if(!input_queue_push(&input_queue, event)) fprintf(stderr, "Input queue full, key dropped.\n");
 }
 
 void error_callback(int error, const char* description)
@@ -105,86 +58,6 @@ void error_callback(int error, const char* description)
 	fprintf(stderr, "Error: %s\n", description);
 }
 
-// Goes over sprite pixels and draws "on" pixels 
-// at specified coordinates if within buffer bounds
-void buffer_draw_sprite(Buffer* buffer, const Sprite& sprite, size_t x, size_t y, uint32_t color)
-{
-	for(size_t xi = 0; xi < sprite.width; ++xi)
-	{
-		for(size_t yi = 0; yi < sprite.height; ++yi)
-		{
-			if(sprite.data[yi * sprite.width + xi] && 
-					(sprite.height - 1 + y - yi) < buffer-> height &&
-					(x + xi) < buffer->width)
-			{
-				buffer->data[(sprite.height - 1 + y - yi) * buffer->width + (x + xi)] = color;
-			}
-		}
-	}
-}
-
-// Draw the text as a sprite at specified coordinates and with specified color
-void buffer_draw_text(Buffer *buffer, const Sprite& text_spritesheet, const char* text, 
-				size_t x, size_t y, uint32_t color){
-		size_t xp = x;
-		// stride is size of one character sprite (7x5 = 35)
-		size_t stride = text_spritesheet.width * text_spritesheet.height;
-		Sprite sprite = text_spritesheet;
-		// iterate through all the characters in the text until the null character
-		for(const char* charp = text; *charp != '\0'; ++charp)
-		{
-			char character = *charp - 32;
-			if (character < 0 || character >= 65) continue;
-			sprite.data = text_spritesheet.data + character * stride;
-			buffer_draw_sprite(buffer, sprite, xp, y, color);
-			xp += sprite.width + 1;
-		}
-}
-
-// Draw numbers
-void buffer_draw_number(Buffer* buffer, const Sprite& number_spritesheet, size_t number,
-				size_t x, size_t y, uint32_t color)
-{
-		uint8_t digits[64];
-		size_t num_digits = 0;
-
-		size_t current_number = number;
-		// Getting digits of the number 
-		do
-		{
-				digits[num_digits++] = current_number % 10;
-				current_number = current_number / 10;
-		}
-		while(current_number > 0);
-		size_t xp = x;
-		size_t stride = number_spritesheet.width * number_spritesheet.height;
-		Sprite sprite = number_spritesheet;
-		for(size_t i = 0; i < num_digits; ++i)
-		{
-				uint8_t digit = digits[num_digits - i - 1];
-				sprite.data = number_spritesheet.data + digit * stride;
-				buffer_draw_sprite(buffer, sprite, xp, y, color);
-				xp += sprite.width + 1;
-		}
-
-}
-
-// Sets the left most 24 bits to the r,g,b values respectively
-// the right-most 8 bits are set to 255 (but not used)
-uint32_t rgb_to_uint32(uint8_t r, uint8_t g, uint8_t b)
-{
-	return (r << 24) | (g << 16) | (b << 8) | 255;
-}
-// Clear the buffer to a certain color
-// Iterate over all pixels and set each pixel to the give color
-void buffer_clear(Buffer* buffer, uint32_t color)
-{ 
-	for(size_t i=0; i< buffer->width * buffer->height; ++i)
-	{
-		buffer->data[i] = color;
-	}
-}
-
 void validate_shader(GLuint shader, const char* file = 0)
 {
 	static const unsigned int BUFFER_SIZE = 512;
@@ -217,23 +90,490 @@ bool validate_program(GLuint program)
 	return true;
 }
 
-bool sprite_overlap_check(
-		const Sprite& sp_a, size_t x_a, size_t y_a,
-		const Sprite& sp_b, size_t x_b, size_t y_b)
+// Deterministic stand-in for the keyboard in headless mode:
+// sweep the player back and forth and fire every few frames
+GameInput headless_input(size_t frame)
 {
-	if(x_a < x_b + sp_b.width && x_a + sp_a.width > x_b &&
-			y_a < y_b + sp_b.height && y_a + sp_a.height > y_b)
+	GameInput input;
+	input.move_dir = ((frame / 100) % 2)? -1: 1;
+	input.fire_pressed = (frame % 8) == 0;
+	return input;
+}
+
+// Macro values spliced into the shader sources
+#define STRINGIFY(x) #x
+#define STRINGIFY_VALUE(x) STRINGIFY(x)
+#define PALETTE_SIZE_STRING STRINGIFY_VALUE(PALETTE_SIZE)
+
+// FNV-1a hash of the buffer colors, to compare the output of different runs.
+// Indices are hashed as the colors of the palette they stand for, so both
+// formats give the same checksum for the same picture
+uint64_t buffer_checksum(const Buffer& buffer, const Palette& palette)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for(size_t i = 0; i < buffer.width * buffer.height; ++i)
 	{
-		return true;
+		uint32_t color = buffer.format == PIXEL_INDEXED? palette.colors[buffer.indices[i]]: buffer.data[i];
+		hash = (hash ^ color) * 1099511628211ull;
+	}
+	return hash;
+}
+
+// Set the palette uniform of the indexed fragment shader
+void upload_palette(GLint location, const Palette& palette)
+{
+	GLfloat colors[3 * PALETTE_SIZE];
+	for(size_t i = 0; i < PALETTE_SIZE; ++i)
+	{
+		uint32_t color = palette.colors[i];
+		colors[3 * i + 0] = ((color >> 24) & 0xff) / 255.0f;
+		colors[3 * i + 1] = ((color >> 16) & 0xff) / 255.0f;
+		colors[3 * i + 2] = ((color >> 8) & 0xff) / 255.0f;
+	}
+	glUniform3fv(location, PALETTE_SIZE, colors);
+}
+
+// Command line options
+struct Options
+{
+	bool headless;
+	size_t num_frames;
+	// Only redraw and upload the regions that changed since the previous frame
+	bool dirty_rects;
+	// Draw palette indices into an 8-bit buffer, the shader looks up the colors
+	PixelFormat format;
+	UploadMode upload_mode;
+	// Simulation ticks per second, independent of the frame rate
+	double tick_rate;
+	// Frame rate cap enforced by the frame pacer, 0 for none
+	double max_fps;
+	bool vsync;
+	// Simulate on a thread of its own while the main thread renders
+	bool sim_thread;
+	// Threads drawing full frames, 1 to draw on the main thread alone
+	size_t render_threads;
+	// Input log to write, or to replay headless instead of the scripted input
+	const char* record_path;
+	const char* replay_path;
+	// Ticks between state hashes in the recorded log
+	size_t hash_interval;
+	// Chrome trace of the profiled scopes to write on exit
+	const char* trace_path;
+	// Video file to write every frame to, see capture.h
+	const char* capture_path;
+	// Asset pack to use instead of the built-in assets, reloaded by the
+	// window whenever it changes
+	const char* assets_path;
+};
+
+// Totals of the per-frame dirty region statistics
+struct DirtyStats
+{
+	size_t frames;
+	size_t dirty_pixels;
+	size_t upload_bytes;
+};
+
+void dirty_stats_add(DirtyStats* stats, const DirtyTracker& tracker)
+{
+	++stats->frames;
+	stats->dirty_pixels += tracker.dirty_pixels;
+	stats->upload_bytes += tracker.upload_bytes;
+}
+
+void dirty_stats_print(const DirtyStats& stats, const Buffer& buffer)
+{
+	if(!stats.frames) return;
+	size_t full_pixels = buffer.width * buffer.height;
+	printf("Dirty rects: %.0f pixels/frame (%.1f%% of the buffer), %.0f bytes changed/frame\n",
+			(double)stats.dirty_pixels / stats.frames,
+			100.0 * stats.dirty_pixels / stats.frames / full_pixels,
+			(double)stats.upload_bytes / stats.frames);
+}
+
+// Work of the render loop, from taking the latest frame to the end of the upload
+struct RenderStats
+{
+	size_t frames;
+	// Frames that showed the same simulation frame as the one before
+	size_t repeated;
+	double sum_ns;
+	uint64_t max_ns;
+};
+
+void render_stats_add(RenderStats* stats, uint64_t elapsed, bool repeated)
+{
+	++stats->frames;
+	stats->repeated += repeated;
+	stats->sum_ns += elapsed;
+	if(elapsed > stats->max_ns) stats->max_ns = elapsed;
+}
+
+void render_stats_print(const RenderStats& stats)
+{
+	if(!stats.frames) return;
+	printf("Render: %.3f ms mean, %.3f ms max to rasterize and upload, %lu frames repeated\n",
+			stats.sum_ns / 1e6 / stats.frames, stats.max_ns / 1e6, stats.repeated);
+}
+
+// Frames of the game loop allowed to allocate while the containers grow to
+// their working size. Past them a frame should not touch the heap
+#define WARMUP_FRAMES 120
+
+// Heap allocations made by the frames of the game loop
+struct AllocStats
+{
+	size_t warmup_allocs;
+	size_t steady_allocs;
+	// Frames past the warm-up that allocated, and the first of them
+	size_t steady_frames;
+	size_t first_steady_frame;
+};
+
+void alloc_stats_add(AllocStats* stats, size_t frame, size_t allocs)
+{
+	if(frame < WARMUP_FRAMES)
+	{
+		stats->warmup_allocs += allocs;
+	}
+	else if(allocs)
+	{
+		if(!stats->steady_frames) stats->first_steady_frame = frame;
+		stats->steady_allocs += allocs;
+		++stats->steady_frames;
 	}
+}
 
+void alloc_stats_print(const AllocStats& stats)
+{
+	printf("Heap allocations: %lu in the first %d frames, %lu after\n",
+			stats.warmup_allocs, WARMUP_FRAMES, stats.steady_allocs);
+	if(stats.steady_allocs)
+	{
+		fprintf(stderr, "%lu frames allocated past the warm-up, the first was frame %lu.\n",
+				stats.steady_frames, stats.first_steady_frame);
+	}
+}
+
+// Map the pack at path and check that a game can use it, or that game
+// can switch to it if given
+bool load_asset_pack(AssetPack* pack, const char* path, const Game* game)
+{
+	if(!asset_pack_open(pack, path))
+	{
+		fprintf(stderr, "Cannot load asset pack %s: %s.\n", path, pack->error);
+		return false;
+	}
+	if(game? !game_assets_compatible(*game, pack->assets): !game_assets_valid(pack->assets))
+	{
+		fprintf(stderr, "Asset pack %s does not fit the game%s.\n", path,
+				game? ", the formation has to keep its size until a restart": "");
+		asset_pack_close(pack);
+		return false;
+	}
+	return true;
+}
+
+// Asset packs of a window that reloads them as they change: the one the game
+// uses, and the one it used before while the switch is under way. The old pack
+// stays mapped until a frame drawn with the new one is read, after which no
+// frame drawn from the old one can be shown
+struct AssetReload
+{
+	const char* path;
+	AssetWatch watch;
+	AssetPack packs[2];
+	// Pack the game uses, -1 for the built-in assets
+	int current;
+	// Pack the game is switching from, or -1
+	int previous;
+	bool switching;
+};
+
+// Reload the pack if it changed and the last switch is complete. Returns
+// true on the frame the game switched, which is drawn with new sprites
+bool asset_reload_update(AssetReload* reload, SimThread* sim, const SimFrame* frame)
+{
+	if(reload->switching)
+	{
+		if(frame->assets != &reload->packs[reload->current].assets) return false;
+		if(reload->previous >= 0) asset_pack_close(&reload->packs[reload->previous]);
+		reload->switching = false;
+		return true;
+	}
+	if(!asset_watch_changed(&reload->watch)) return false;
+
+	int next = reload->current == 0? 1: 0;
+	if(!load_asset_pack(&reload->packs[next], reload->path, sim->game)) return false;
+	// No switch is pending, the last one reached the reader
+	sim_thread_set_assets(sim, &reload->packs[next].assets);
+	reload->previous = reload->current;
+	reload->current = next;
+	reload->switching = true;
+	printf("Reloaded asset pack %s\n", reload->path);
 	return false;
 }
 
+// Print the phase timings, and write the trace if asked to.
+// Both need a build with -DPROFILE
+void profile_report(const Options& options)
+{
+	profiler_print();
+	if(!options.trace_path) return;
+#ifdef PROFILE
+	if(profiler_write_trace(options.trace_path)) printf("Trace written to %s\n", options.trace_path);
+	else fprintf(stderr, "Cannot write trace %s.\n", options.trace_path);
+#else
+	fprintf(stderr, "Not writing trace %s, profiling needs a build with -DPROFILE.\n", options.trace_path);
+#endif
+}
+
+// Run the game loop without a window, as fast as possible
+int run_headless(const Options& options, size_t buffer_width, size_t buffer_height)
+{
+	AssetPack pack = {};
+	if(options.assets_path && !load_asset_pack(&pack, options.assets_path, NULL)) return -1;
+
+	// A replay runs on a screen of the size it was recorded with
+	InputLog replay = {};
+	if(options.replay_path)
+	{
+		if(!input_log_open(&replay, options.replay_path))
+		{
+			fprintf(stderr, "Cannot read input log %s.\n", options.replay_path);
+			asset_pack_close(&pack);
+			return -1;
+		}
+		printf("Replaying %s, recorded at %.0f Hz on %ux%u, state hash every %u ticks\n",
+				options.replay_path, replay.tick_rate, replay.width, replay.height, replay.hash_interval);
+		buffer_width = replay.width;
+		buffer_height = replay.height;
+	}
+
+	// Memory living as long as the game, and the scratch space of a frame
+	Arena level, frame;
+	arena_init(&level);
+	arena_init(&frame);
+
+	Buffer buffer;
+	buffer.width = buffer_width;
+	buffer.height = buffer_height;
+	buffer.format = options.format;
+	buffer.data = NULL;
+	buffer.indices = NULL;
+	if(buffer.format == PIXEL_INDEXED) buffer.indices = arena_alloc_array<uint8_t>(&level, buffer.width * buffer.height);
+	else buffer.data = arena_alloc_array<uint32_t>(&level, buffer.width * buffer.height);
+
+	const GameAssets& assets = options.assets_path? pack.assets: game_assets;
+
+	Game game;
+	game_init(&game, &level, &assets, buffer_width, buffer_height);
+
+	DrawList draw_list;
+	draw_list_init(&draw_list);
+	DirtyTracker tracker;
+	dirty_tracker_init(&tracker);
+	DirtyStats dirty_stats = {};
+	ThreadPool pool;
+	thread_pool_init(&pool, options.render_threads);
+	TileRenderer renderer;
+	tile_renderer_init(&renderer, &pool, buffer.height);
+
+	InputLog record = {};
+	if(options.record_path && !input_log_create(&record, options.record_path, options.hash_interval,
+				options.tick_rate, buffer.width, buffer.height))
+	{
+		fprintf(stderr, "Cannot create input log %s.\n", options.record_path);
+		return -1;
+	}
+	// Headless captures wait for the writer rather than lose frames
+	Capture capture = {};
+	if(options.capture_path && !capture_open(&capture, &level, options.capture_path,
+				buffer.width, buffer.height, options.tick_rate, true))
+	{
+		fprintf(stderr, "Cannot create capture %s.\n", options.capture_path);
+		return -1;
+	}
+
+	// Every frame is one tick, from the log or from the script
+	size_t num_frames = 0;
+	size_t hashes_checked = 0;
+	bool diverged = false;
+	AllocStats alloc_stats = {};
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(;; ++num_frames)
+	{
+		GameInput input;
+		bool has_hash = false;
+		uint32_t hash = 0;
+		if(replay.file)
+		{
+			if(!input_log_read(&replay, &input, &has_hash, &hash)) break;
+		}
+		else
+		{
+			if(num_frames == options.num_frames) break;
+			input = headless_input(num_frames);
+		}
+		size_t allocs = alloc_count();
+		PROFILE_SCOPE("frame");
+
+		if(options.dirty_rects)
+		{
+			game_draw(game, &draw_list);
+			dirty_tracker_render(&tracker, &buffer, draw_list, &frame);
+			dirty_stats_add(&dirty_stats, tracker);
+			game_simulate(&game, input);
+		}
+		else if(options.render_threads > 1)
+		{
+			game_draw(game, &draw_list);
+			tile_renderer_render(&renderer, &buffer, draw_list, &frame);
+			game_simulate(&game, input);
+		}
+		else
+		{
+			game_step(&game, &draw_list, &buffer, input);
+		}
+		arena_reset(&frame);
+		if(capture.file) capture_frame(&capture, buffer, game.palette, 1);
+
+		if(record.file) input_log_write(&record, input, game);
+		alloc_stats_add(&alloc_stats, num_frames, alloc_count() - allocs);
+		if(has_hash)
+		{
+			++hashes_checked;
+			if(input_log_hash(game_hash(game)) != hash)
+			{
+				diverged = true;
+				++num_frames;
+				break;
+			}
+		}
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	printf("Headless: %lu frames in %.3f s\n", num_frames, seconds);
+	printf("%.0f frames/sec, %.1f ns/frame\n",
+			num_frames / seconds, seconds * 1e9 / num_frames);
+	dirty_stats_print(dirty_stats, buffer);
+	alloc_stats_print(alloc_stats);
+	printf("Final score: %lu, frame checksum: %016llx\n",
+			game.score, (unsigned long long)buffer_checksum(buffer, game.palette));
+	if(replay.file)
+	{
+		if(diverged) printf("Replay diverged at tick %lu\n", num_frames);
+		else printf("Replay matched: %lu ticks, %lu state hashes checked\n", num_frames, hashes_checked);
+		input_log_close(&replay);
+	}
+	if(record.file)
+	{
+		printf("Recorded %lu ticks in %lu bytes\n", record.ticks, record.bytes);
+		input_log_close(&record);
+	}
+	if(capture.file)
+	{
+		capture_close(&capture);
+		capture_print_stats(capture);
+	}
+
+	thread_pool_free(&pool);
+	profile_report(options);
+	dirty_tracker_free(&tracker);
+	draw_list_free(&draw_list);
+	game_free(&game);
+	asset_pack_close(&pack);
+	arena_free(&frame);
+	arena_free(&level);
+
+	return (diverged || alloc_stats.steady_allocs)? 1: 0;
+}
+
 int main(int argc, char* argv[]) {
 	const size_t buffer_width = 224;
 	const size_t buffer_height = 256;
 
+	Options options;
+	options.headless = false;
+	options.num_frames = 10000;
+	options.dirty_rects = false;
+	options.format = PIXEL_RGBA;
+	options.upload_mode = UPLOAD_SYNC;
+	options.tick_rate = 60;
+	options.max_fps = 0;
+	options.vsync = true;
+	options.render_threads = 1;
+	options.sim_thread = true;
+	options.record_path = NULL;
+	options.replay_path = NULL;
+	options.hash_interval = 60;
+	options.trace_path = NULL;
+	options.capture_path = NULL;
+	options.assets_path = NULL;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--headless") == 0) options.headless = true;
+		else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) options.num_frames = strtoul(argv[++i], NULL, 10);
+		else if(strcmp(argv[i], "--dirty-rects") == 0) options.dirty_rects = true;
+		else if(strcmp(argv[i], "--indexed") == 0) options.format = PIXEL_INDEXED;
+		else if(strcmp(argv[i], "--upload") == 0 && i + 1 < argc && strcmp(argv[i + 1], "sync") == 0)
+		{
+			options.upload_mode = UPLOAD_SYNC;
+			++i;
+		}
+		else if(strcmp(argv[i], "--upload") == 0 && i + 1 < argc && strcmp(argv[i + 1], "pbo") == 0)
+		{
+			options.upload_mode = UPLOAD_PBO;
+			++i;
+		}
+		else if(strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0) options.tick_rate = atof(argv[++i]);
+		else if(strcmp(argv[i], "--max-fps") == 0 && i + 1 < argc) options.max_fps = atof(argv[++i]);
+		else if(strcmp(argv[i], "--no-vsync") == 0) options.vsync = false;
+		else if(strcmp(argv[i], "--no-sim-thread") == 0) options.sim_thread = false;
+		else if(strcmp(argv[i], "--render-threads") == 0 && i + 1 < argc)
+		{
+			options.render_threads = strtoul(argv[++i], NULL, 10);
+			if(!options.render_threads) options.render_threads = thread_pool_hardware_threads();
+		}
+		else if(strcmp(argv[i], "--record") == 0 && i + 1 < argc) options.record_path = argv[++i];
+		else if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+		{
+			options.replay_path = argv[++i];
+			options.headless = true;
+		}
+		else if(strcmp(argv[i], "--hash-interval") == 0 && i + 1 < argc) options.hash_interval = strtoul(argv[++i], NULL, 10);
+		else if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc) options.trace_path = argv[++i];
+		else if(strcmp(argv[i], "--capture") == 0 && i + 1 < argc) options.capture_path = argv[++i];
+		else if(strcmp(argv[i], "--assets") == 0 && i + 1 < argc) options.assets_path = argv[++i];
+		else if(strcmp(argv[i], "--simd") == 0 && i + 1 < argc)
+		{
+			if(!simd_select(argv[++i]))
+			{
+				fprintf(stderr, "Instruction set %s is not supported.\n", argv[i]);
+				return -1;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--headless] [--frames N] [--simd scalar|sse2|avx2|avx512] [--dirty-rects] [--indexed] [--upload sync|pbo]\n"
+					"       [--tick-rate HZ] [--max-fps FPS] [--no-vsync] [--no-sim-thread] [--render-threads N]\n"
+					"       [--record FILE] [--replay FILE] [--hash-interval TICKS] [--trace FILE] [--capture FILE]\n"
+					"       [--assets FILE]\n", argv[0]);
+			return -1;
+		}
+	}
+	printf("Raster kernels: %s\n", raster_kernels.name);
+	if(options.render_threads > 1 && !options.dirty_rects)
+	{
+		printf("Render threads: %lu\n", options.render_threads);
+	}
+
+	if(options.headless)
+	{
+		return run_headless(options, buffer_width, buffer_height);
+	}
+
 	glfwSetErrorCallback(error_callback);
 	GLFWwindow* window;
 	if(!glfwInit())
@@ -257,6 +597,7 @@ int main(int argc, char* argv[]) {
 		return -1;
 	}
 
+	input_queue_init(&input_queue);
 	// Set GLFW key callback 
 	glfwSetKeyCallback(window, key_callback);
 
@@ -264,6 +605,8 @@ int main(int argc, char* argv[]) {
 	glfwMakeContextCurrent(window);
 
 	// Initialize GLEW aftering making current context
+	// GLEW only loads every function of a core profile context in experimental mode
+	glewExperimental = GL_TRUE;
 	GLenum err = glewInit();
 	if(err != GLEW_OK)
 	{
@@ -281,21 +624,21 @@ int main(int argc, char* argv[]) {
     printf("Renderer used: %s\n", glGetString(GL_RENDERER));
     printf("Shading Language: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
 
-	// Turn V-Sync on to syncrhonize video card updates
-	// with monitor refresh rate. For 60Hz refresh rate, framerate of game is 60
-	glfwSwapInterval(1);
+	// Turn V-Sync on to syncrhonize video card updates with monitor refresh rate.
+	// The game speed does not depend on it, the simulation runs at a fixed tick rate
+	glfwSwapInterval(options.vsync? 1: 0);
 
 	// infinite game loop to process input and update and redraw game
 	// set the buffer clear color for glClear to red
 	glClearColor(1.0, 0.0, 0.0, 1.0);
 
-	// Create graphics buffer
+	// Create graphics buffer, its pixels are provided by the texture upload
 	Buffer buffer;
 	buffer.width = buffer_width;
 	buffer.height = buffer_height;
-	buffer.data = new uint32_t[buffer.width * buffer.height];
-
-	buffer_clear(&buffer, 0); 
+	buffer.format = options.format;
+	buffer.data = NULL;
+	buffer.indices = NULL;
 
 	// Texture holds image data 
 	// as well as information about formatting of the data
@@ -304,14 +647,27 @@ int main(int argc, char* argv[]) {
 
 	// Specify image format and behavior of sampling of the texture
 	glBindTexture(GL_TEXTURE_2D, buffer_texture);
-	// Image should 8-bit rgb format to represent texture internally
-	glTexImage2D(
-			GL_TEXTURE_2D, 0, GL_RGB8,
-			buffer.width, buffer.height, 0, 
-			// each pixel is in rgba format 
-			// and represented as 4 unsigned 8-bit integers
-			GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, buffer.data
-			);
+	if(buffer.format == PIXEL_INDEXED)
+	{
+		// One 8-bit palette index per pixel
+		glTexImage2D(
+				GL_TEXTURE_2D, 0, GL_R8,
+				buffer.width, buffer.height, 0,
+				GL_RED, GL_UNSIGNED_BYTE, NULL
+				);
+	}
+	else
+	{
+		// Kept as 8-bit RGBA internally, the layout the pixels are streamed in,
+		// so the driver does not repack every upload. The shader ignores alpha
+		glTexImage2D(
+				GL_TEXTURE_2D, 0, GL_RGBA8,
+				buffer.width, buffer.height, 0,
+				// each pixel is in rgba format
+				// and represented as 4 unsigned 8-bit integers
+				GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, NULL
+				);
+	}
 	// Tell gpu to not apply any filtering when rading pixels
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -356,6 +712,23 @@ int main(int argc, char* argv[]) {
 		"    outColor = texture(buffer, TexCoord).rgb;\n"
 		"}\n";
 
+	// The same with the red channel of the buffer as a palette index
+	const char* indexed_fragment_shader =
+		"\n"
+		"#version 330\n"
+		"\n"
+		"uniform sampler2D buffer;\n"
+		"uniform vec3 palette[" PALETTE_SIZE_STRING "];\n"
+		"noperspective in vec2 TexCoord;\n"
+		"\n"
+		"out vec3 outColor;\n"
+		"\n"
+		"void main(void){\n"
+		"    int index = int(texture(buffer, TexCoord).r * 255.0 + 0.5);\n"
+		"    outColor = palette[min(index, " PALETTE_SIZE_STRING " - 1)];\n"
+		"}\n";
+	if(buffer.format == PIXEL_INDEXED) fragment_shader = indexed_fragment_shader;
+
 
 	GLuint shader_id = glCreateProgram();
 
@@ -391,7 +764,6 @@ int main(int argc, char* argv[]) {
 		fprintf(stderr, "Error while validating shader.\n");
 		glfwTerminate();
 		glDeleteVertexArrays(1, &fullscreen_triangle_vao);
-		delete[] buffer.data;
 		return -1;
 	}
 
@@ -401,7 +773,7 @@ int main(int argc, char* argv[]) {
 	// set the uniform to texture unit '0'
 	GLint location = glGetUniformLocation(shader_id, "buffer");
 	glUniform1i(location, 0);
-
+	GLint palette_location = glGetUniformLocation(shader_id, "palette");
 
 
 	//OpenGL setup
@@ -410,445 +782,211 @@ int main(int argc, char* argv[]) {
 
 	glBindVertexArray(fullscreen_triangle_vao);
 
-	// Prepare game
-	Sprite alien_sprites[6];
-
-	alien_sprites[0].width = 8;
-	alien_sprites[0].height = 8;
-	alien_sprites[0].data = new uint8_t[64]
-	{
-		0,0,0,1,1,0,0,0, // ...@@...
-		0,0,1,1,1,1,0,0, // ..@@@@..
-		0,1,1,1,1,1,1,0, // .@@@@@@.
-		1,1,0,1,1,0,1,1, // @@.@@.@@
-		1,1,1,1,1,1,1,1, // @@@@@@@@
-		0,1,0,1,1,0,1,0, // .@.@@.@.
-		1,0,0,0,0,0,0,1, // @......@
-		0,1,0,0,0,0,1,0  // .@....@.
-	};
-
-	alien_sprites[1].width = 8;
-	alien_sprites[1].height = 8;
-	alien_sprites[1].data = new uint8_t[64]
-	{
-		0,0,0,1,1,0,0,0, // ...@@...
-		0,0,1,1,1,1,0,0, // ..@@@@..
-		0,1,1,1,1,1,1,0, // .@@@@@@.
-		1,1,0,1,1,0,1,1, // @@.@@.@@
-		1,1,1,1,1,1,1,1, // @@@@@@@@
-		0,0,1,0,0,1,0,0, // ..@..@..
-		0,1,0,1,1,0,1,0, // .@.@@.@.
-		1,0,1,0,0,1,0,1  // @.@..@.@
-	};
-	alien_sprites[2].width = 11;
-	alien_sprites[2].height = 8;
-	alien_sprites[2].data = new uint8_t[88]
-	{
-		0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
-		0,0,0,1,0,0,0,1,0,0,0, // ...@...@...
-		0,0,1,1,1,1,1,1,1,0,0, // ..@@@@@@@..
-		0,1,1,0,1,1,1,0,1,1,0, // .@@.@@@.@@.
-		1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
-		1,0,1,1,1,1,1,1,1,0,1, // @.@@@@@@@.@
-		1,0,1,0,0,0,0,0,1,0,1, // @.@.....@.@
-		0,0,0,1,1,0,1,1,0,0,0  // ...@@.@@...
-	};
-
-	alien_sprites[3].width = 11;
-	alien_sprites[3].height = 8;
-	alien_sprites[3].data = new uint8_t[88]
-	{
-		0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
-		1,0,0,1,0,0,0,1,0,0,1, // @..@...@..@
-		1,0,1,1,1,1,1,1,1,0,1, // @.@@@@@@@.@
-		1,1,1,0,1,1,1,0,1,1,1, // @@@.@@@.@@@
-		1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
-		0,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@.
-		0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
-		0,1,0,0,0,0,0,0,0,1,0  // .@.......@.
-	};
-	alien_sprites[4].width = 12;
-	alien_sprites[4].height = 8;
-	alien_sprites[4].data = new uint8_t[96]
-	{
-		0,0,0,0,1,1,1,1,0,0,0,0, // ....@@@@....
-		0,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@.
-		1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
-		1,1,1,0,0,1,1,0,0,1,1,1, // @@@..@@..@@@
-		1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
-		0,0,0,1,1,0,0,1,1,0,0,0, // ...@@..@@...
-		0,0,1,1,0,1,1,0,1,1,0,0, // ..@@.@@.@@..
-		1,1,0,0,0,0,0,0,0,0,1,1  // @@........@@
-	};
-
-	alien_sprites[5].width = 12;
-	alien_sprites[5].height = 8;
-	alien_sprites[5].data = new uint8_t[96]
-	{
-		0,0,0,0,1,1,1,1,0,0,0,0, // ....@@@@....
-		0,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@.
-		1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
-		1,1,1,0,0,1,1,0,0,1,1,1, // @@@..@@..@@@
-		1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
-		0,0,1,1,1,0,0,1,1,1,0,0, // ..@@@..@@@..
-		0,1,1,0,0,1,1,0,0,1,1,0, // .@@..@@..@@.
-		0,0,1,1,0,0,0,0,1,1,0,0  // ..@@....@@..
-	};
-	Sprite alien_death_sprite;
-	alien_death_sprite.width = 13;
-	alien_death_sprite.height = 7;
-	alien_death_sprite.data = new uint8_t[alien_death_sprite.width * alien_death_sprite.height]
-	{
-		0,1,0,0,1,0,0,0,1,0,0,1,0, // .@..@...@..@.
-		0,0,1,0,0,1,0,1,0,0,1,0,0, // ..@..@.@..@..
-		0,0,0,1,0,0,0,0,0,1,0,0,0, // ...@.....@...
-		1,1,0,0,0,0,0,0,0,0,0,1,1, // @@.........@@
-		0,0,0,1,0,0,0,0,0,1,0,0,0, // ...@.....@...
-		0,0,1,0,0,1,0,1,0,0,1,0,0, // ..@..@.@..@..
-		0,1,0,0,1,0,0,0,1,0,0,1,0  // .@..@...@..@.
-	};
-	Sprite player_sprite;
-	player_sprite.width = 11;
-	player_sprite.height = 7;
-	player_sprite.data = new uint8_t[player_sprite.width * player_sprite.height]
-	{
-		0,0,0,0,0,1,0,0,0,0,0, // .....@.....
-		0,0,0,0,1,1,1,0,0,0,0, // ....@@@....
-		0,0,0,0,1,1,1,0,0,0,0, // ....@@@....
-		0,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@.
-		1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
-		1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
-		1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
-	};
-
-	Sprite text_spritesheet;
-	text_spritesheet.width = 5;
-	text_spritesheet.height = 7;
-	// 65 5x7 characters starting from 'space' at 32 in ASCII to '`' ASCII 96
-	text_spritesheet.data = new uint8_t[65 * 35]
-	{
-		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,1,0,0,
-        0,1,0,1,0,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,1,0,1,0,0,1,0,1,0,1,1,1,1,1,0,1,0,1,0,1,1,1,1,1,0,1,0,1,0,0,1,0,1,0,
-        0,0,1,0,0,0,1,1,1,0,1,0,1,0,0,0,1,1,1,0,0,0,1,0,1,0,1,1,1,0,0,0,1,0,0,
-        1,1,0,1,0,1,1,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,1,1,0,1,0,1,1,
-        0,1,1,0,0,1,0,0,1,0,1,0,0,1,0,0,1,1,0,0,1,0,0,1,0,1,0,0,0,1,0,1,1,1,1,
-        0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,
-        1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,
-        0,0,1,0,0,1,0,1,0,1,0,1,1,1,0,0,0,1,0,0,0,1,1,1,0,1,0,1,0,1,0,0,1,0,0,
-        0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,1,1,1,1,1,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,
-        0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,
-
-        0,1,1,1,0,1,0,0,0,1,1,0,0,1,1,1,0,1,0,1,1,1,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        0,0,1,0,0,0,1,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,1,1,0,
-        0,1,1,1,0,1,0,0,0,1,0,0,0,0,1,0,0,1,1,0,0,1,0,0,0,1,0,0,0,0,1,1,1,1,1,
-        1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,1,0,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        0,0,0,1,0,0,0,1,1,0,0,1,0,1,0,1,0,0,1,0,1,1,1,1,1,0,0,0,1,0,0,0,0,1,0,
-        1,1,1,1,1,1,0,0,0,0,1,1,1,1,0,0,0,0,0,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-
-        0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,
-        0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,
-        0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,
-        1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,
-        0,1,1,1,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,1,0,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,1,0,1,1,1,0,1,1,1,0,1,0,0,1,0,0,0,1,0,1,1,1,0,
-
-        0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,1,1,0,0,0,1,1,0,0,0,1,
-        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,1,1,1,0,
-        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,
-        1,1,1,1,1,1,0,0,0,0,1,0,0,0,0,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,1,1,1,1,
-        1,1,1,1,1,1,0,0,0,0,1,0,0,0,0,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,0,1,1,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,1,1,1,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,
-        0,1,1,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,1,1,0,
-        0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        1,0,0,0,1,1,0,0,1,0,1,0,1,0,0,1,1,0,0,0,1,0,1,0,0,1,0,0,1,0,1,0,0,0,1,
-        1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,1,1,1,1,
-        1,0,0,0,1,1,1,0,1,1,1,0,1,0,1,1,0,1,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,
-        1,0,0,0,1,1,0,0,0,1,1,1,0,0,1,1,0,1,0,1,1,0,0,1,1,1,0,0,0,1,1,0,0,0,1,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,1,0,1,1,0,0,1,1,0,1,1,1,1,
-        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,1,0,0,1,0,0,1,0,1,0,0,0,1,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,0,1,1,1,0,1,0,0,0,1,0,0,0,0,1,0,1,1,1,0,
-        1,1,1,1,1,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,
-        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,
-        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,1,0,1,1,0,1,0,1,1,1,0,1,1,1,0,0,0,1,
-        1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,1,0,0,0,1,
-        1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,
-        1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,1,1,1,1,
-
-        0,0,0,1,1,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,1,
-        0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,
-        1,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,1,1,0,0,0,
-        0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,
-        0,0,1,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
-};
-
-	// number_spritesheet is just a reference into text_spritesheet starting at position 16
-	Sprite number_spritesheet = text_spritesheet;
-	number_spritesheet.data += 16 *35;
-
-
-	Sprite bullet_sprite;
-	bullet_sprite.width = 1;
-	bullet_sprite.height = 3;
-	bullet_sprite.data = new uint8_t[3]
+	// Prepare game, along with the memory living as long as it and the
+	// scratch space of a frame
+	Arena level, frame;
+	arena_init(&level);
+	arena_init(&frame);
+
+	// Without a usable pack the game starts with the built-in assets, and
+	// switches to the pack once it is fixed
+	AssetReload reload = {};
+	reload.path = options.assets_path;
+	reload.current = reload.previous = -1;
+	reload.watch.watching = false;
+	if(reload.path)
 	{
-		1, // @
-			1, // @
-			1  // @
-	};
+		if(load_asset_pack(&reload.packs[0], reload.path, NULL)) reload.current = 0;
+		if(!asset_watch_init(&reload.watch, reload.path))
+		{
+			fprintf(stderr, "Cannot watch %s, not reloading it.\n", reload.path);
+		}
+	}
+	const GameAssets& assets = reload.current == 0? reload.packs[0].assets: game_assets;
 
-	SpriteAnimation alien_animation[3];
+	Game game;
+	game_init(&game, &level, &assets, buffer_width, buffer_height);
 
-	for(size_t i=0; i<3; ++i)
+	TextureUpload upload;
+	if(!texture_upload_init(&upload, &level, options.upload_mode, buffer.format, buffer_texture,
+				buffer.width, buffer.height, options.capture_path != NULL))
 	{
-		alien_animation[i].loop = true;
-		alien_animation[i].num_frames = 2;
-		alien_animation[i].frame_duration = 10;
-		alien_animation[i].time = 0;
-
-		alien_animation[i].frames = new Sprite*[2];
-		alien_animation[i].frames[0] = &alien_sprites[2 * i];
-		alien_animation[i].frames[1] = &alien_sprites[2 * i +1];
+		fprintf(stderr, "Persistently mapped buffers are not supported, using synchronous upload.\n");
 	}
 
-	Game game;
-	game.width = buffer_width;
-	game.height = buffer_height;
-	game.num_aliens = 55;
-    game.num_bullets = 0;
-	game.aliens = new Alien[game.num_aliens];
-
-	game.player.x = 112 - 5;
-	game.player.y = 32;
-
-	game.player.life = 3;
-
-	// Initialize all the alien positions to something reasonable
-	for(size_t yi = 0; yi < 5; ++yi)
-    {
-        for(size_t xi = 0; xi < 11; ++xi)
-        {
-            Alien& alien = game.aliens[yi * 11 + xi];
-            alien.type = (5 - yi) / 2 + 1;
-
-            const Sprite& sprite = alien_sprites[2 * (alien.type - 1)];
-
-            alien.x = 16 * xi + 20 + (alien_death_sprite.width - sprite.width)/2;
-            alien.y = 17 * yi + 128;
-        }
-}
-	// Array of death counters
-	uint8_t* death_counters = new uint8_t[game.num_aliens];
-	for(size_t i = 0; i < game.num_aliens; ++i)
+	// Each ring slot of the upload keeps the frame it was last drawn with
+	DirtyTracker trackers[UPLOAD_RING_SIZE];
+	for(size_t i = 0; i < UPLOAD_RING_SIZE; ++i)
+	{
+		dirty_tracker_init(&trackers[i]);
+	}
+	DirtyStats dirty_stats = {};
+	Rect full_rect = {0, 0, buffer.width, buffer.height};
+	ThreadPool pool;
+	thread_pool_init(&pool, options.render_threads);
+	TileRenderer renderer;
+	tile_renderer_init(&renderer, &pool, buffer.height);
+
+	FramePacer pacer;
+	frame_pacer_init(&pacer, options.max_fps);
+
+	InputLog record = {};
+	if(options.record_path && !input_log_create(&record, options.record_path, options.hash_interval,
+				options.tick_rate, buffer.width, buffer.height))
+	{
+		fprintf(stderr, "Cannot create input log %s, not recording.\n", options.record_path);
+	}
+	// Frames are dropped rather than hold up the window when the disk falls behind
+	Capture capture = {};
+	if(options.capture_path && !capture_open(&capture, &level, options.capture_path,
+				buffer.width, buffer.height, options.tick_rate, false))
 	{
-		death_counters[i] = 10;
+		fprintf(stderr, "Cannot create capture %s, not capturing.\n", options.capture_path);
 	}
 
+	// From here on the game belongs to the simulation, the loop only sees
+	// the frames it publishes
+	SimThread sim;
+	sim_thread_init(&sim, &game, &input_queue, &record, options.tick_rate);
+	if(options.sim_thread) sim_thread_start(&sim);
+
+	size_t num_frames = 0;
+	AllocStats alloc_stats = {};
+	RenderStats render_stats = {};
+	const SimFrame* previous_frame = NULL;
+	size_t previous_ticks = 0;
+	// Ticks the captured video frames stand for
+	size_t captured_ticks = 0;
+	// The palette the shader holds, sent again whenever the game changes it
+	Palette uploaded_palette = game.palette;
+	if(buffer.format == PIXEL_INDEXED) upload_palette(palette_location, uploaded_palette);
+
 	// set the game_running global to true
 	game_running = true;
-	size_t score = 0;
-	size_t credits = 0;
-	uint32_t clear_color = rgb_to_uint32(0, 128, 0);
-    int player_move_dir = 0;
 
 	while (!glfwWindowShouldClose(window) && game_running)
 	{
-		buffer_clear(&buffer, clear_color); // clear_color = green
-		buffer_draw_text(
-						&buffer,
-						text_spritesheet, "SCORE",
-						4, game.height -text_spritesheet.height - 7,
-						rgb_to_uint32(128,0,0)
-						);
-		char credit_text[16];
-		sprintf(credit_text, "CREDIT %02lu", credits);
-		buffer_draw_text(
-						&buffer,
-						text_spritesheet, credit_text, 
-						164, 7, 
-						rgb_to_uint32(128, 0, 0)
-						);
-
-		buffer_draw_number(
-						&buffer,
-						number_spritesheet, score,
-						4 + 2 * number_spritesheet.width, game.height - 2 * number_spritesheet.height - 12,
-						rgb_to_uint32(128,0,0)
-						);
-
-		for(size_t i = 0; i < game.width; ++i)
-		{
-				buffer.data[game.width * 16 + i] = rgb_to_uint32(128, 0, 0);
-		}
+		size_t allocs = alloc_count();
+		PROFILE_SCOPE("frame");
+		if(!options.sim_thread) sim_thread_step(&sim, time_ns());
 
-		// Draw the aliens  
-		for(size_t ai = 0; ai < game.num_aliens; ++ai)
+		uint64_t render_start = time_ns();
+		const SimFrame* sim_frame = sim_thread_latest(&sim);
+		if(reload.watch.watching && asset_reload_update(&reload, &sim, sim_frame))
 		{
-			// draw the alien only if death counter is bigger than 0
-			if(!death_counters[ai]) continue;
-
-			const Alien& alien = game.aliens[ai];
-			if(alien.type == ALIEN_DEAD)
+			// A new pack may be mapped where an old one was, with other sprites
+			// behind the same row pointers
+			for(size_t i = 0; i < UPLOAD_RING_SIZE; ++i)
 			{
-				buffer_draw_sprite(&buffer, alien_death_sprite, alien.x, alien.y, rgb_to_uint32(128, 0, 0));
-			}
-			else
-			{
-				const SpriteAnimation& animation = alien_animation[alien.type - 1];
-				size_t current_frame = animation.time / animation.frame_duration;
-				const Sprite& sprite = *animation.frames[current_frame];
-				buffer_draw_sprite(&buffer, sprite, alien.x, alien.y, rgb_to_uint32(128,0,0));
+				dirty_tracker_invalidate(&trackers[i]);
 			}
 		}
-
-		// Draw the bullets
-		for(size_t bi = 0; bi < game.num_bullets; ++bi)
+		bool repeated = previous_frame && sim_frame->ticks == previous_ticks;
+		previous_frame = sim_frame;
+		previous_ticks = sim_frame->ticks;
+		const DrawList& draw_list = sim_frame->list;
+		if(buffer.format == PIXEL_INDEXED && memcmp(&uploaded_palette, &sim_frame->palette, sizeof(Palette)) != 0)
 		{
-			const Bullet& bullet = game.bullets[bi];
-			const Sprite& sprite = bullet_sprite;
-			buffer_draw_sprite(&buffer, sprite, bullet.x, bullet.y, rgb_to_uint32(128, 0, 0));
+			uploaded_palette = sim_frame->palette;
+			upload_palette(palette_location, uploaded_palette);
 		}
 
-		buffer_draw_sprite(&buffer, player_sprite, game.player.x, game.player.y, rgb_to_uint32(128, 0, 0));
-
-		// Update animations
-		for(size_t i = 0; i < 3; ++i)
 		{
-			++alien_animation[i].time;
-			if(alien_animation[i].time == alien_animation[i].num_frames * alien_animation[i].frame_duration)
-			{
-				alien_animation[i].time = 0;
-			}
+			PROFILE_SCOPE("upload wait");
+			texture_upload_begin(&upload, &buffer);
 		}
-		glTexSubImage2D(
-				GL_TEXTURE_2D, 0, 0, 0,
-				buffer.width, buffer.height,
-				GL_RGBA, GL_UNSIGNED_INT_8_8_8_8,
-				buffer.data
-				);
-
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-		// front buffer is used for displaying, back buffer is used for drawing
-		// swapping buffers at each iteration
-		glfwSwapBuffers(window);
-
-
-		// Simulate aliens. Decrease death counter every frame 
-		for(size_t ai = 0; ai <game.num_aliens; ++ai)
+		const Rect* upload_rects = &full_rect;
+		size_t num_upload_rects = 1;
+		if(options.dirty_rects)
 		{
-			const Alien& alien = game.aliens[ai];
-			if(alien.type == ALIEN_DEAD && death_counters[ai])
-			{
-				--death_counters[ai];
-			}
+			DirtyTracker& tracker = trackers[upload.slot];
+			dirty_tracker_render(&tracker, &buffer, draw_list, &frame);
+			dirty_stats_add(&dirty_stats, tracker);
+			upload_rects = tracker.rects;
+			num_upload_rects = tracker.num_rects;
 		}
-
-
-		// Simulate bullets. Add dir, and remove projectiles that move out of game area
-		for(size_t bi = 0; bi < game.num_bullets;)
+		else
 		{
-			game.bullets[bi].y += game.bullets[bi].dir;
-			if(game.bullets[bi].y >= game.height ||
-					game.bullets[bi].y < bullet_sprite.height)
-			{
-				game.bullets[bi] = game.bullets[game.num_bullets - 1];
-				--game.num_bullets;
-				continue;
-			}
-
-			// Check if a bullet its an alien that is alive 
-			for(size_t ai = 0; ai < game.num_aliens; ++ai)
-			{
-				const Alien& alien = game.aliens[ai];
-				if(alien.type == ALIEN_DEAD) continue;
-
-				const SpriteAnimation& animation = alien_animation[alien.type - 1];
-				size_t current_frame = animation.time / animation.frame_duration;
-				const Sprite& alien_sprite = *animation.frames[current_frame];
-				bool overlap = sprite_overlap_check(
-						bullet_sprite, game.bullets[bi].x, game.bullets[bi].y,
-						alien_sprite, alien.x, alien.y
-						);
-				if(overlap)
-				{
-					// Based on the alien type, add score between 10 - 40 points
-					score += 10 * (4 - game.aliens[ai].type);
-					game.aliens[ai].type = ALIEN_DEAD;
-					// NOTE: Hack to recenter death sprite
-					game.aliens[ai].x -= (alien_death_sprite.width - alien_sprite.width)/2;
-					game.bullets[bi] = game.bullets[game.num_bullets - 1];
-					--game.num_bullets;
-					continue;
-				}
-			}
-			++bi;	
+			if(options.render_threads > 1) tile_renderer_render(&renderer, &buffer, draw_list, &frame);
+			else draw_list_render(&buffer, draw_list);
 		}
-
-		// Simulate player
-		// variable that controls player direction of movement
-		int player_move_dir = move_dir;
-
-		if(player_move_dir != 0){
-			// Basic collision detection of player sprite with the wall
-			if(game.player.x + player_sprite.width + player_move_dir >= game.width -1)
-			{
-				// can't go past boundary
-				game.player.x = game.width - player_sprite.width;
-			}
-			else if((int)game.player.x + player_move_dir <= 0)
-			{
-				game.player.x = 0;
-			}
-			else game.player.x += player_move_dir;
+		{
+			PROFILE_SCOPE("upload");
+			texture_upload_end(&upload, buffer, upload_rects, num_upload_rects);
 		}
-		
-		// Process events
-		if(fire_pressed && game.num_bullets < GAME_MAX_BULLETS)
+		render_stats_add(&render_stats, time_ns() - render_start, repeated);
+		// One video frame per tick, so the video plays at game speed even when
+		// a batch runs several ticks
+		if(capture.file && sim_frame->ticks != captured_ticks)
 		{
-			game.bullets[game.num_bullets].x = game.player.x + player_sprite.width / 2;
-			game.bullets[game.num_bullets].y = game.player.y + player_sprite.height;
-			game.bullets[game.num_bullets].dir = 2;
-			++game.num_bullets;
+			capture_frame(&capture, buffer, sim_frame->palette, sim_frame->ticks - captured_ticks);
+			captured_ticks = sim_frame->ticks;
 		}
-		fire_pressed = false;
 
+		{
+			PROFILE_SCOPE("swap");
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+			// front buffer is used for displaying, back buffer is used for drawing
+			// swapping buffers at each iteration
+			glfwSwapBuffers(window);
+		}
+		++num_frames;
+
+		{
+			PROFILE_SCOPE("pace");
+			frame_pacer_wait(&pacer);
+		}
 
 		// processing any pending events
-		glfwPollEvents();
+		{
+			PROFILE_SCOPE("poll events");
+			glfwPollEvents();
+		}
+
+		arena_reset(&frame);
+		alloc_stats_add(&alloc_stats, num_frames - 1, alloc_count() - allocs);
 	}
+	sim_thread_stop(&sim);
+	printf("%lu frames, %lu ticks at %.0f Hz%s\n", num_frames, sim.num_ticks, options.tick_rate,
+			options.sim_thread? " on the simulation thread": "");
+	frame_pacer_print_stats(pacer);
+	sim_thread_print_stats(sim);
+	render_stats_print(render_stats);
+	dirty_stats_print(dirty_stats, buffer);
+	texture_upload_print_stats(upload);
+	alloc_stats_print(alloc_stats);
+	profile_report(options);
+	if(record.file)
+	{
+		printf("Recorded %lu ticks in %lu bytes\n", record.ticks, record.bytes);
+		input_log_close(&record);
+	}
+	if(capture.file)
+	{
+		capture_close(&capture);
+		capture_print_stats(capture);
+	}
+
+	// GL objects go before the context they belong to
+	texture_upload_free(&upload);
+	glDeleteVertexArrays(1, &fullscreen_triangle_vao);
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
-	glDeleteVertexArrays(1, &fullscreen_triangle_vao);
-	for(size_t i = 0; i < 6; ++i)
+	thread_pool_free(&pool);
+	for(size_t i = 0; i < UPLOAD_RING_SIZE; ++i)
 	{
-		delete[] alien_sprites[i].data;
-	} 
-	delete[] text_spritesheet.data;
-	delete[] alien_death_sprite.data;
-	for(size_t i = 0; i < 3; ++i)
+		dirty_tracker_free(&trackers[i]);
+	}
+	sim_thread_free(&sim);
+	game_free(&game);
+	asset_watch_free(&reload.watch);
+	for(size_t i = 0; i < 2; ++i)
 	{
-		delete[] alien_animation[i].frames;
+		asset_pack_close(&reload.packs[i]);
 	}
-	delete[] buffer.data;
-	delete[] game.aliens;
-	delete[] death_counters;
+	arena_free(&frame);
+	arena_free(&level);
 
 	return 0;
 }
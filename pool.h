@@ -0,0 +1,297 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Refers to an item of a Pool: its slot and the generation of the slot when
+// the item was added. The generation changes when the item is removed, so a
+// handle to a removed item never resolves, even once the slot is reused
+struct PoolHandle
+{
+	uint32_t index;
+	uint32_t generation;
+};
+
+#define POOL_CHUNK_SIZE 256
+
+// Items live in fixed size chunks that are never moved or freed while the
+// pool is in use, so adding items only allocates a new chunk when all the
+// slots are taken and pointers to items stay valid until they are removed
+template<typename T>
+struct PoolChunk
+{
+	// Bit i is set while slot i holds an item
+	uint64_t live[POOL_CHUNK_SIZE / 64];
+	uint32_t generation[POOL_CHUNK_SIZE];
+	// Next slot of the free list, -1 at the end
+	int32_t next_free[POOL_CHUNK_SIZE];
+	T items[POOL_CHUNK_SIZE];
+};
+
+// Unbounded set of items of type T, with O(1) add and remove that reuse
+// the freed slots first. T is copied around with memcpy semantics
+template<typename T>
+struct Pool
+{
+	PoolChunk<T>** chunks;
+	size_t num_chunks;
+	size_t chunks_capacity;
+	// First free slot, -1 if all the slots are taken
+	int32_t free_head;
+	size_t count;
+};
+
+template<typename T>
+void pool_init(Pool<T>* pool)
+{
+	pool->chunks = NULL;
+	pool->num_chunks = 0;
+	pool->chunks_capacity = 0;
+	pool->free_head = -1;
+	pool->count = 0;
+}
+
+template<typename T>
+void pool_free(Pool<T>* pool)
+{
+	for(size_t c = 0; c < pool->num_chunks; ++c)
+	{
+		delete pool->chunks[c];
+	}
+	delete[] pool->chunks;
+	pool_init(pool);
+}
+
+// Remove every item. Generations are kept so older handles stay stale
+template<typename T>
+void pool_clear(Pool<T>* pool)
+{
+	pool->free_head = -1;
+	for(size_t c = pool->num_chunks; c-- > 0;)
+	{
+		PoolChunk<T>* chunk = pool->chunks[c];
+		for(size_t i = POOL_CHUNK_SIZE; i-- > 0;)
+		{
+			if((chunk->live[i / 64] >> (i % 64)) & 1) ++chunk->generation[i];
+			chunk->next_free[i] = pool->free_head;
+			pool->free_head = c * POOL_CHUNK_SIZE + i;
+		}
+		memset(chunk->live, 0, sizeof(chunk->live));
+	}
+	pool->count = 0;
+}
+
+template<typename T>
+PoolHandle pool_add(Pool<T>* pool, const T& item)
+{
+	if(pool->free_head < 0)
+	{
+		// Only the array of chunk pointers is reallocated
+		if(pool->num_chunks == pool->chunks_capacity)
+		{
+			size_t capacity = pool->chunks_capacity? 2 * pool->chunks_capacity: 4;
+			PoolChunk<T>** chunks = new PoolChunk<T>*[capacity];
+			if(pool->num_chunks) memcpy(chunks, pool->chunks, pool->num_chunks * sizeof(PoolChunk<T>*));
+			delete[] pool->chunks;
+			pool->chunks = chunks;
+			pool->chunks_capacity = capacity;
+		}
+		PoolChunk<T>* chunk = new PoolChunk<T>;
+		memset(chunk->live, 0, sizeof(chunk->live));
+		memset(chunk->generation, 0, sizeof(chunk->generation));
+		// Chained so that the lowest slots are handed out first
+		size_t base = pool->num_chunks * POOL_CHUNK_SIZE;
+		for(size_t i = 0; i < POOL_CHUNK_SIZE; ++i)
+		{
+			chunk->next_free[i] = i + 1 < POOL_CHUNK_SIZE? base + i + 1: -1;
+		}
+		pool->chunks[pool->num_chunks++] = chunk;
+		pool->free_head = base;
+	}
+
+	uint32_t index = pool->free_head;
+	PoolChunk<T>* chunk = pool->chunks[index / POOL_CHUNK_SIZE];
+	size_t slot = index % POOL_CHUNK_SIZE;
+	pool->free_head = chunk->next_free[slot];
+	chunk->live[slot / 64] |= (uint64_t)1 << (slot % 64);
+	chunk->items[slot] = item;
+	++pool->count;
+
+	PoolHandle handle = {index, chunk->generation[slot]};
+	return handle;
+}
+
+// The item the handle refers to, NULL if it was removed
+template<typename T>
+T* pool_get(const Pool<T>& pool, PoolHandle handle)
+{
+	if(handle.index / POOL_CHUNK_SIZE >= pool.num_chunks) return NULL;
+	PoolChunk<T>* chunk = pool.chunks[handle.index / POOL_CHUNK_SIZE];
+	size_t slot = handle.index % POOL_CHUNK_SIZE;
+	if(chunk->generation[slot] != handle.generation) return NULL;
+	if(!((chunk->live[slot / 64] >> (slot % 64)) & 1)) return NULL;
+	return &chunk->items[slot];
+}
+
+// Returns false if the item was already removed
+template<typename T>
+bool pool_remove(Pool<T>* pool, PoolHandle handle)
+{
+	if(!pool_get(*pool, handle)) return false;
+	PoolChunk<T>* chunk = pool->chunks[handle.index / POOL_CHUNK_SIZE];
+	size_t slot = handle.index % POOL_CHUNK_SIZE;
+	chunk->live[slot / 64] &= ~((uint64_t)1 << (slot % 64));
+	++chunk->generation[slot];
+	chunk->next_free[slot] = pool->free_head;
+	pool->free_head = handle.index;
+	--pool->count;
+	return true;
+}
+
+// Bytes pool_save writes: a small header and every chunk as it is in memory
+template<typename T>
+size_t pool_snapshot_size(const Pool<T>& pool)
+{
+	return 2 * sizeof(uint64_t) + pool.num_chunks * sizeof(PoolChunk<T>);
+}
+
+// Copy the complete state of the pool, free list included, so that a pool
+// loaded from it hands out the same slots in the same order
+template<typename T>
+void pool_save(const Pool<T>& pool, uint8_t* out)
+{
+	uint64_t header[2] = {(uint64_t)pool.num_chunks | ((uint64_t)(uint32_t)pool.free_head << 32), pool.count};
+	memcpy(out, header, sizeof(header));
+	out += sizeof(header);
+	for(size_t c = 0; c < pool.num_chunks; ++c)
+	{
+		memcpy(out, pool.chunks[c], sizeof(PoolChunk<T>));
+		out += sizeof(PoolChunk<T>);
+	}
+}
+
+// Whether the size bytes at in are a pool as pool_save writes it: the
+// chunks fill them exactly, count is the number of live slots and the free
+// list links every other slot once. Checked before pool_load trusts them
+template<typename T>
+bool pool_snapshot_valid(const uint8_t* in, size_t size)
+{
+	uint64_t header[2];
+	if(size < sizeof(header)) return false;
+	memcpy(header, in, sizeof(header));
+	size_t num_chunks = header[0] & 0xffffffff;
+	int32_t index = (int32_t)(uint32_t)(header[0] >> 32);
+	if((size - sizeof(header)) % sizeof(PoolChunk<T>) != 0 ||
+			(size - sizeof(header)) / sizeof(PoolChunk<T>) != num_chunks)
+	{
+		return false;
+	}
+
+	// The chunks are read in place, they need not be aligned in the blob
+	const uint8_t* chunks = in + sizeof(header);
+	size_t live = 0;
+	for(size_t c = 0; c < num_chunks; ++c)
+	{
+		uint64_t words[POOL_CHUNK_SIZE / 64];
+		memcpy(words, chunks + c * sizeof(PoolChunk<T>) + offsetof(PoolChunk<T>, live), sizeof(words));
+		for(size_t w = 0; w < POOL_CHUNK_SIZE / 64; ++w)
+		{
+			live += __builtin_popcountll(words[w]);
+		}
+	}
+	if(header[1] != live) return false;
+
+	// A list that visits a live slot, or more slots than are free, is broken
+	size_t num_free = num_chunks * POOL_CHUNK_SIZE - live;
+	size_t visited = 0;
+	for(; index != -1; ++visited)
+	{
+		if(index < 0 || (size_t)index / POOL_CHUNK_SIZE >= num_chunks || visited == num_free) return false;
+		const uint8_t* chunk = chunks + index / POOL_CHUNK_SIZE * sizeof(PoolChunk<T>);
+		size_t slot = index % POOL_CHUNK_SIZE;
+		uint64_t word;
+		memcpy(&word, chunk + offsetof(PoolChunk<T>, live) + slot / 64 * sizeof(uint64_t), sizeof(word));
+		if((word >> (slot % 64)) & 1) return false;
+		memcpy(&index, chunk + offsetof(PoolChunk<T>, next_free) + slot * sizeof(int32_t), sizeof(index));
+	}
+	return visited == num_free;
+}
+
+// Restore a state written by pool_save, checked with pool_snapshot_valid.
+// Chunks are only allocated or freed if the number of chunks differs
+template<typename T>
+void pool_load(Pool<T>* pool, const uint8_t* in)
+{
+	uint64_t header[2];
+	memcpy(header, in, sizeof(header));
+	in += sizeof(header);
+	size_t num_chunks = header[0] & 0xffffffff;
+
+	while(pool->num_chunks > num_chunks)
+	{
+		delete pool->chunks[--pool->num_chunks];
+	}
+	if(num_chunks > pool->chunks_capacity)
+	{
+		PoolChunk<T>** chunks = new PoolChunk<T>*[num_chunks];
+		if(pool->num_chunks) memcpy(chunks, pool->chunks, pool->num_chunks * sizeof(PoolChunk<T>*));
+		delete[] pool->chunks;
+		pool->chunks = chunks;
+		pool->chunks_capacity = num_chunks;
+	}
+	while(pool->num_chunks < num_chunks)
+	{
+		pool->chunks[pool->num_chunks++] = new PoolChunk<T>;
+	}
+
+	for(size_t c = 0; c < num_chunks; ++c)
+	{
+		memcpy(pool->chunks[c], in, sizeof(PoolChunk<T>));
+		in += sizeof(PoolChunk<T>);
+	}
+	pool->free_head = (int32_t)(uint32_t)(header[0] >> 32);
+	pool->count = header[1];
+}
+
+// Call visit(handle, item) for every item in slot order. The visit may
+// remove the item it is given; items added during the walk may or may not
+// be visited
+template<typename T, typename Visit>
+void pool_for_each(Pool<T>* pool, Visit visit)
+{
+	for(size_t c = 0; c < pool->num_chunks; ++c)
+	{
+		PoolChunk<T>* chunk = pool->chunks[c];
+		for(size_t w = 0; w < POOL_CHUNK_SIZE / 64; ++w)
+		{
+			for(uint64_t live = chunk->live[w]; live; live &= live - 1)
+			{
+				size_t slot = w * 64 + __builtin_ctzll(live);
+				PoolHandle handle = {(uint32_t)(c * POOL_CHUNK_SIZE + slot), chunk->generation[slot]};
+				visit(handle, chunk->items[slot]);
+			}
+		}
+	}
+}
+
+template<typename T, typename Visit>
+void pool_for_each(const Pool<T>& pool, Visit visit)
+{
+	for(size_t c = 0; c < pool.num_chunks; ++c)
+	{
+		const PoolChunk<T>* chunk = pool.chunks[c];
+		for(size_t w = 0; w < POOL_CHUNK_SIZE / 64; ++w)
+		{
+			for(uint64_t live = chunk->live[w]; live; live &= live - 1)
+			{
+				size_t slot = w * 64 + __builtin_ctzll(live);
+				PoolHandle handle = {(uint32_t)(c * POOL_CHUNK_SIZE + slot), chunk->generation[slot]};
+				visit(handle, chunk->items[slot]);
+			}
+		}
+	}
+}
+
+#endif
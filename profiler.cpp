@@ -0,0 +1,213 @@
+#include "profiler.h"
+
+#ifdef PROFILE
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+struct ProfileEvent
+{
+	const char* name;
+	uint64_t start_ns;
+	uint64_t end_ns;
+};
+
+struct ProfilePhase
+{
+	const char* name;
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint64_t buckets[PROFILE_BUCKETS];
+};
+
+// What one thread recorded. Only that thread writes to it
+struct ProfileThread
+{
+	size_t id;
+	// Ring of the last PROFILE_RING_SIZE scopes, and scopes recorded in total
+	ProfileEvent* events;
+	size_t num_events;
+	ProfilePhase* phases;
+	size_t num_phases;
+};
+
+// Threads that recorded something, in the order they started.
+// The records live until the program ends, past the threads themselves
+static std::mutex profile_mutex;
+static ProfileThread** profile_threads = NULL;
+static size_t profile_num_threads = 0;
+static size_t profile_threads_capacity = 0;
+static thread_local ProfileThread* profile_thread = NULL;
+// Trace timestamps count from here
+static const uint64_t profile_epoch_ns = time_ns();
+
+static ProfileThread* profiler_register_thread()
+{
+	ProfileThread* thread = new ProfileThread;
+	thread->events = new ProfileEvent[PROFILE_RING_SIZE];
+	thread->num_events = 0;
+	thread->phases = new ProfilePhase[PROFILE_MAX_PHASES];
+	thread->num_phases = 0;
+
+	std::lock_guard<std::mutex> lock(profile_mutex);
+	if(profile_num_threads == profile_threads_capacity)
+	{
+		profile_threads_capacity = profile_threads_capacity? 2 * profile_threads_capacity: 16;
+		ProfileThread** threads = new ProfileThread*[profile_threads_capacity];
+		for(size_t i = 0; i < profile_num_threads; ++i)
+		{
+			threads[i] = profile_threads[i];
+		}
+		delete[] profile_threads;
+		profile_threads = threads;
+	}
+	thread->id = profile_num_threads;
+	profile_threads[profile_num_threads++] = thread;
+	return thread;
+}
+
+static size_t profile_bucket(uint64_t ns)
+{
+	if(ns < 16) return ns;
+	size_t exponent = 63 - __builtin_clzll(ns);
+	return 16 + (exponent - 4) * 8 + ((ns >> (exponent - 3)) & 7);
+}
+
+// Largest duration that falls in the bucket
+static uint64_t profile_bucket_limit(size_t bucket)
+{
+	if(bucket < 16) return bucket;
+	size_t exponent = (bucket - 16) / 8 + 4;
+	uint64_t mantissa = 8 + (bucket - 16) % 8 + 1;
+	return (mantissa << (exponent - 3)) - 1;
+}
+
+void profiler_record(const char* name, uint64_t start_ns, uint64_t end_ns)
+{
+	ProfileThread* thread = profile_thread;
+	if(!thread) thread = profile_thread = profiler_register_thread();
+
+	ProfileEvent& event = thread->events[thread->num_events++ % PROFILE_RING_SIZE];
+	event.name = name;
+	event.start_ns = start_ns;
+	event.end_ns = end_ns;
+
+	// Few phases per thread, a scan by pointer is cheaper than hashing
+	ProfilePhase* phase = NULL;
+	for(size_t i = 0; i < thread->num_phases; ++i)
+	{
+		if(thread->phases[i].name == name)
+		{
+			phase = &thread->phases[i];
+			break;
+		}
+	}
+	if(!phase)
+	{
+		if(thread->num_phases == PROFILE_MAX_PHASES) return;
+		phase = &thread->phases[thread->num_phases++];
+		memset(phase, 0, sizeof(ProfilePhase));
+		phase->name = name;
+	}
+
+	uint64_t duration = end_ns - start_ns;
+	++phase->count;
+	phase->total_ns += duration;
+	if(duration > phase->max_ns) phase->max_ns = duration;
+	++phase->buckets[profile_bucket(duration)];
+}
+
+static uint64_t profile_percentile(const ProfilePhase& phase, double fraction)
+{
+	uint64_t rank = (uint64_t)(fraction * phase.count);
+	if(rank >= phase.count) rank = phase.count - 1;
+	uint64_t seen = 0;
+	for(size_t b = 0; b < PROFILE_BUCKETS; ++b)
+	{
+		seen += phase.buckets[b];
+		if(seen > rank) return std::min(profile_bucket_limit(b), phase.max_ns);
+	}
+	return phase.max_ns;
+}
+
+static bool profile_phase_more_total(const ProfilePhase& a, const ProfilePhase& b)
+{
+	return a.total_ns > b.total_ns;
+}
+
+void profiler_print()
+{
+	std::lock_guard<std::mutex> lock(profile_mutex);
+
+	// The same phase recorded on several threads, or with the same name
+	// from several files, is merged into one line
+	size_t capacity = profile_num_threads * PROFILE_MAX_PHASES;
+	if(!capacity) return;
+	ProfilePhase* phases = new ProfilePhase[capacity];
+	size_t num_phases = 0;
+	for(size_t t = 0; t < profile_num_threads; ++t)
+	{
+		const ProfileThread& thread = *profile_threads[t];
+		for(size_t i = 0; i < thread.num_phases; ++i)
+		{
+			const ProfilePhase& phase = thread.phases[i];
+			size_t p = 0;
+			while(p < num_phases && strcmp(phases[p].name, phase.name) != 0) ++p;
+			if(p == num_phases)
+			{
+				phases[num_phases++] = phase;
+				continue;
+			}
+			phases[p].count += phase.count;
+			phases[p].total_ns += phase.total_ns;
+			phases[p].max_ns = std::max(phases[p].max_ns, phase.max_ns);
+			for(size_t b = 0; b < PROFILE_BUCKETS; ++b)
+			{
+				phases[p].buckets[b] += phase.buckets[b];
+			}
+		}
+	}
+	std::sort(phases, phases + num_phases, profile_phase_more_total);
+
+	printf("Profile, %lu threads:\n", profile_num_threads);
+	printf("  %-16s %10s %10s %10s %10s %10s\n", "phase", "count", "p50 us", "p99 us", "max us", "total ms");
+	for(size_t p = 0; p < num_phases; ++p)
+	{
+		const ProfilePhase& phase = phases[p];
+		printf("  %-16s %10lu %10.2f %10.2f %10.2f %10.1f\n", phase.name, phase.count,
+				profile_percentile(phase, 0.5) / 1e3, profile_percentile(phase, 0.99) / 1e3,
+				phase.max_ns / 1e3, phase.total_ns / 1e6);
+	}
+	delete[] phases;
+}
+
+bool profiler_write_trace(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if(!file) return false;
+
+	std::lock_guard<std::mutex> lock(profile_mutex);
+	fprintf(file, "{\"traceEvents\":[\n");
+	for(size_t t = 0; t < profile_num_threads; ++t)
+	{
+		const ProfileThread& thread = *profile_threads[t];
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"thread %lu\"}}",
+				t? ",\n": "", thread.id, thread.id);
+
+		size_t begin = thread.num_events > PROFILE_RING_SIZE? thread.num_events - PROFILE_RING_SIZE: 0;
+		for(size_t i = begin; i < thread.num_events; ++i)
+		{
+			const ProfileEvent& event = thread.events[i % PROFILE_RING_SIZE];
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+					event.name, thread.id, (event.start_ns - profile_epoch_ns) / 1e3,
+					(event.end_ns - event.start_ns) / 1e3);
+		}
+	}
+	fprintf(file, "\n]}\n");
+	return fclose(file) == 0;
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "timing.h"
+
+// Scoped timers for the phases of a frame. In a build with -DPROFILE every
+// PROFILE_SCOPE("name") times the rest of its block and records it on the
+// calling thread: into a histogram per phase, for the p50/p99/max printed
+// by profiler_print, and into a ring of the last PROFILE_RING_SIZE scopes,
+// for the trace written by profiler_write_trace. Threads never share what
+// they record, so scopes need no locking. Without -DPROFILE the macro
+// expands to nothing and the functions do nothing.
+// Names must be string literals, they are kept by pointer
+
+// Scopes each thread keeps for the trace, the older ones are overwritten
+#define PROFILE_RING_SIZE 65536
+// Different phases a thread can record, further ones are ignored
+#define PROFILE_MAX_PHASES 64
+// Histogram buckets: one per ns below 16 ns, then 8 per power of two,
+// so a percentile is within 12.5% of the true value
+#define PROFILE_BUCKETS 496
+
+#ifdef PROFILE
+
+// Record a finished scope of the calling thread
+void profiler_record(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+struct ProfileScope
+{
+	const char* name;
+	uint64_t start_ns;
+
+	ProfileScope(const char* name): name(name), start_ns(time_ns()) {}
+	~ProfileScope() { profiler_record(name, start_ns, time_ns()); }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+
+// Print count, p50, p99, max and total of every phase, over all threads.
+// Call once the other threads are done recording
+void profiler_print();
+
+// Write the scopes in the rings as a Chrome trace-event JSON file, to open
+// in chrome://tracing or Perfetto. Returns false if the file cannot be written
+bool profiler_write_trace(const char* path);
+
+#else
+
+#define PROFILE_SCOPE(name)
+
+inline void profiler_print() {}
+inline bool profiler_write_trace(const char*) { return false; }
+
+#endif
+
+#endif
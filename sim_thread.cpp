@@ -0,0 +1,146 @@
+#include <cstdio>
+#include "sim_thread.h"
+#include "profiler.h"
+#include "timing.h"
+
+// Record the game as it is into the back frame and hand it to the reader
+static void sim_thread_publish(SimThread* sim)
+{
+	TextCache* cache = &sim->game->hud->cache;
+	SimFrame* frame = triple_buffer_back(&sim->frames);
+	text_cache_take_drawn(cache);
+	game_draw(*sim->game, &frame->list);
+	frame->text_entries = text_cache_take_drawn(cache);
+	frame->palette = sim->game->palette;
+	frame->list.palette = &frame->palette;
+	frame->assets = sim->game->assets;
+	frame->ticks = sim->num_ticks;
+	triple_buffer_publish(&sim->frames);
+
+	// Until the next publish the reader may hold or take any slot but the
+	// new back one
+	uint32_t pinned = 0;
+	for(size_t i = 0; i < 3; ++i)
+	{
+		if(i != sim->frames.back) pinned |= sim->frames.slots[i].text_entries;
+	}
+	text_cache_pin(cache, pinned);
+}
+
+void sim_thread_init(SimThread* sim, Game* game, InputQueue* input, InputLog* record, double tick_rate)
+{
+	sim->game = game;
+	sim->input = input;
+	sim->record = record;
+	sim->tick_ns = (uint64_t)(1e9 / tick_rate);
+	sim->accumulator = 0;
+	sim->previous_time = time_ns();
+	input_state_init(&sim->input_state);
+	sim->input_latency = InputLatency();
+	sim->num_ticks = 0;
+	sim->batches = 0;
+	sim->batch_sum_ns = 0;
+	sim->batch_max_ns = 0;
+	triple_buffer_init(&sim->frames);
+	sim->pending_assets.store(NULL, std::memory_order_relaxed);
+	for(size_t i = 0; i < 3; ++i)
+	{
+		draw_list_init(&sim->frames.slots[i].list);
+		sim->frames.slots[i].text_entries = 0;
+	}
+	sim->quit.store(false, std::memory_order_relaxed);
+	sim->running = false;
+
+	sim_thread_publish(sim);
+	triple_buffer_acquire(&sim->frames);
+}
+
+void sim_thread_free(SimThread* sim)
+{
+	for(size_t i = 0; i < 3; ++i)
+	{
+		draw_list_free(&sim->frames.slots[i].list);
+	}
+}
+
+bool sim_thread_step(SimThread* sim, uint64_t now)
+{
+	uint64_t tick_ns = sim->tick_ns;
+	sim->accumulator += now - sim->previous_time;
+	sim->previous_time = now;
+	if(sim->accumulator > SIM_MAX_TICKS_PER_BATCH * tick_ns) sim->accumulator = SIM_MAX_TICKS_PER_BATCH * tick_ns;
+	if(sim->accumulator < tick_ns) return false;
+
+	PROFILE_SCOPE("sim batch");
+	const GameAssets* assets = sim->pending_assets.exchange(NULL, std::memory_order_acquire);
+	if(assets) game_set_assets(sim->game, assets);
+	while(sim->accumulator >= tick_ns)
+	{
+		// The tick covers the tick_ns up to now - accumulator + tick_ns and
+		// applies the events stamped before its end. The last tick of the
+		// batch also takes those of the time left in the accumulator,
+		// rather than hold them back for a batch
+		uint64_t tick_end = sim->accumulator < 2 * tick_ns? now: now - sim->accumulator + tick_ns;
+		GameInput input = input_state_tick(&sim->input_state, sim->input, tick_end, time_ns(),
+				&sim->input_latency);
+		game_simulate(sim->game, input);
+		if(sim->record && sim->record->file) input_log_write(sim->record, input, *sim->game);
+		sim->accumulator -= tick_ns;
+		++sim->num_ticks;
+	}
+	sim_thread_publish(sim);
+
+	uint64_t elapsed = time_ns() - now;
+	++sim->batches;
+	sim->batch_sum_ns += elapsed;
+	if(elapsed > sim->batch_max_ns) sim->batch_max_ns = elapsed;
+	return true;
+}
+
+static void sim_thread_run(SimThread* sim)
+{
+	while(!sim->quit.load(std::memory_order_relaxed))
+	{
+		if(!sim_thread_step(sim, time_ns()))
+		{
+			// Sleep until the next tick is due
+			std::this_thread::sleep_for(std::chrono::nanoseconds(sim->tick_ns - sim->accumulator));
+		}
+	}
+}
+
+void sim_thread_start(SimThread* sim)
+{
+	sim->previous_time = time_ns();
+	sim->running = true;
+	sim->thread = std::thread(sim_thread_run, sim);
+}
+
+void sim_thread_stop(SimThread* sim)
+{
+	if(!sim->running) return;
+	sim->quit.store(true, std::memory_order_relaxed);
+	sim->thread.join();
+	sim->running = false;
+}
+
+bool sim_thread_set_assets(SimThread* sim, const GameAssets* assets)
+{
+	const GameAssets* expected = NULL;
+	return sim->pending_assets.compare_exchange_strong(expected, assets, std::memory_order_release,
+			std::memory_order_relaxed);
+}
+
+const SimFrame* sim_thread_latest(SimThread* sim)
+{
+	triple_buffer_acquire(&sim->frames);
+	return triple_buffer_front(&sim->frames);
+}
+
+void sim_thread_print_stats(const SimThread& sim)
+{
+	if(sim.batches == 0) return;
+	printf("Simulation: %lu batches, %.3f ms mean, %.3f ms max to simulate and draw\n",
+			sim.batches, sim.batch_sum_ns / 1e6 / sim.batches, sim.batch_max_ns / 1e6);
+	input_latency_print(sim.input_latency);
+}
@@ -0,0 +1,92 @@
+#ifndef SIM_THREAD_H
+#define SIM_THREAD_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include "draw_list.h"
+#include "game.h"
+#include "input_log.h"
+#include "input_queue.h"
+#include "triple_buffer.h"
+
+// Past this many ticks in one batch the simulation falls behind
+// instead of spending ever longer catching up
+#define SIM_MAX_TICKS_PER_BATCH 8
+
+// What the renderer needs of the game at one point in time. Nothing in it
+// changes once published: the list only points to the game's assets and
+// to text cache entries pinned for as long as the frame can be read, and
+// carries its own copy of the palette
+struct SimFrame
+{
+	DrawList list;
+	Palette palette;
+	// Assets the sprites of the list come from
+	const GameAssets* assets;
+	// Ticks simulated when the frame was drawn
+	size_t ticks;
+	// Text cache entries the list draws, see text_cache_take_drawn. Only
+	// the simulation side uses it
+	uint32_t text_entries;
+};
+
+// Runs the game at a fixed tick rate and publishes a SimFrame after every
+// batch of ticks. Started as a thread, the simulation of the next frame
+// overlaps the rasterization and presentation of the previous one; without
+// a thread the render loop calls sim_thread_step itself, one batch per frame.
+//
+// The text cache entries of the two slots other than the back one are
+// pinned, so the strings of a frame the renderer holds, or may take next,
+// are never rasterized over
+struct SimThread
+{
+	Game* game;
+	// Events from the window, this is the consuming side
+	InputQueue* input;
+	// Log to record the ticks to, or NULL
+	InputLog* record;
+	uint64_t tick_ns;
+	// Time not yet simulated, consumed in fixed ticks
+	uint64_t accumulator;
+	uint64_t previous_time;
+	InputState input_state;
+	InputLatency input_latency;
+	size_t num_ticks;
+	// Batches that published a frame, and the time spent simulating and drawing them
+	size_t batches;
+	double batch_sum_ns;
+	uint64_t batch_max_ns;
+	TripleBuffer<SimFrame> frames;
+	// Assets to switch the game to at the next batch, see sim_thread_set_assets
+	std::atomic<const GameAssets*> pending_assets;
+	std::thread thread;
+	std::atomic<bool> quit;
+	bool running;
+};
+
+// Publishes the frame of the game as it is, so there is one to render from the start
+void sim_thread_init(SimThread* sim, Game* game, InputQueue* input, InputLog* record, double tick_rate);
+void sim_thread_free(SimThread* sim);
+
+// Run the ticks due by now and publish the frame they lead to. Returns
+// false, without publishing, if no tick was due
+bool sim_thread_step(SimThread* sim, uint64_t now);
+
+// Step on a thread of its own until sim_thread_stop
+void sim_thread_start(SimThread* sim);
+void sim_thread_stop(SimThread* sim);
+
+// Have the game use assets, compatible with it, from the next batch on.
+// Only one switch can be pending at a time: returns false if the previous
+// one was not taken yet. The frames drawn before the switch keep using the
+// old assets, which must stay alive until a frame with the new ones is read
+bool sim_thread_set_assets(SimThread* sim, const GameAssets* assets);
+
+// Reader side: the most recently published frame
+const SimFrame* sim_thread_latest(SimThread* sim);
+
+void sim_thread_print_stats(const SimThread& sim);
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Sprite sizes (width, height) that get a blit kernel of their own, with
+// the row count and the vector stores per row fixed at compile time
+#define SPRITE_BLIT_SIZES(SIZE) \
+	SIZE(8, 8) SIZE(11, 8) SIZE(12, 8) SIZE(11, 7) SIZE(13, 7) SIZE(5, 7) SIZE(1, 3)
+
+#define SPRITE_BLIT_ENUM(w, h) SPRITE_BLIT_##w##x##h,
+enum SpriteBlitSize
+{
+	SPRITE_BLIT_SIZES(SPRITE_BLIT_ENUM)
+	NUM_SPRITE_BLIT_SIZES
+};
+#undef SPRITE_BLIT_ENUM
+
+// Draw num_rows row masks of a sprite, top row first. Row yi goes to
+// dst - yi * stride, and dst[i] of that row is set to color for every bit i
+// set in both the row mask and column_mask. Pixels whose bit is clear are
+// not touched, not even read
+typedef void (*SpriteBlit)(uint32_t* dst, size_t stride, const uint32_t* rows,
+		size_t num_rows, uint32_t column_mask, uint32_t color);
+// The same for one byte per pixel
+typedef void (*SpriteBlit8)(uint8_t* dst, size_t stride, const uint32_t* rows,
+		size_t num_rows, uint32_t column_mask, uint8_t color);
+
+// Framebuffer kernels for one instruction set. The best set the CPU supports
+// is selected at startup, with a scalar fallback
+struct RasterKernels
+{
+	const char* name;
+	// Set count pixels starting at dst to color
+	void (*fill)(uint32_t* dst, size_t count, uint32_t color);
+	// Any sprite, or any part of one
+	SpriteBlit blit_sprite;
+	// A whole sprite of one of the SPRITE_BLIT_SIZES, which ignore num_rows
+	SpriteBlit blit_sprite_fixed[NUM_SPRITE_BLIT_SIZES];
+	// The same two for palette indices
+	SpriteBlit8 blit_sprite8;
+	SpriteBlit8 blit_sprite8_fixed[NUM_SPRITE_BLIT_SIZES];
+};
+
+// Index into blit_sprite_fixed for a sprite size, NUM_SPRITE_BLIT_SIZES if
+// the size has no kernel of its own
+inline size_t sprite_blit_index(size_t width, size_t height)
+{
+	if(width > 0xff || height > 0xff) return NUM_SPRITE_BLIT_SIZES;
+	switch(width << 8 | height)
+	{
+#define SPRITE_BLIT_CASE(w, h) case w << 8 | h: return SPRITE_BLIT_##w##x##h;
+	SPRITE_BLIT_SIZES(SPRITE_BLIT_CASE)
+#undef SPRITE_BLIT_CASE
+	default: return NUM_SPRITE_BLIT_SIZES;
+	}
+}
+
+// Kernels used by the buffer_* functions
+extern RasterKernels raster_kernels;
+
+// Kernels for the best instruction set reported by cpuid
+RasterKernels simd_detect();
+
+// Select kernels by name ("scalar", "sse2", "avx2", "avx512").
+// Returns false if the name is unknown or the CPU does not support it
+bool simd_select(const char* name);
+
+#endif
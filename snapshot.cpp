@@ -0,0 +1,205 @@
+#include <cstring>
+#include "snapshot.h"
+
+static size_t align8(size_t size)
+{
+	return (size + 7) & ~(size_t)7;
+}
+
+// Bytes of the alien arrays in the blob
+static size_t aliens_size(size_t count)
+{
+	return 2 * align8(count * sizeof(int16_t)) + 2 * align8(count) +
+			(count + 63) / 64 * sizeof(uint64_t) + align8(count * sizeof(uint32_t));
+}
+
+static uint8_t* put(uint8_t* out, const void* data, size_t size)
+{
+	memcpy(out, data, size);
+	return out + align8(size);
+}
+
+static const uint8_t* get(const uint8_t* in, void* data, size_t size)
+{
+	memcpy(data, in, size);
+	return in + align8(size);
+}
+
+size_t game_snapshot_size(const Game& game)
+{
+	return sizeof(GameSnapshotHeader) + aliens_size(game.aliens.count) + pool_snapshot_size(game.bullets);
+}
+
+size_t game_snapshot_save(const Game& game, void* blob, size_t capacity)
+{
+	size_t size = game_snapshot_size(game);
+	if(size > capacity) return 0;
+
+	GameSnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "SISS", 4);
+	header.version = GAME_SNAPSHOT_VERSION;
+	header.size = size;
+	header.num_aliens = game.aliens.count;
+	header.bullet_size = sizeof(Bullet);
+	header.width = game.width;
+	header.height = game.height;
+	header.player_x = game.player.x;
+	header.player_y = game.player.y;
+	header.player_life = game.player.life;
+	header.score = game.score;
+	header.credits = game.credits;
+	for(size_t i = 0; i < 3; ++i)
+	{
+		header.animation_time[i] = game.alien_animation[i].time;
+	}
+	header.march_x = game.march.x;
+	header.march_y = game.march.y;
+	header.march_dir = game.march.dir;
+	header.march_countdown = game.march.countdown;
+
+	const AlienStore& aliens = game.aliens;
+	uint8_t* out = put((uint8_t*)blob, &header, sizeof(header));
+	out = put(out, aliens.x, aliens.count * sizeof(int16_t));
+	out = put(out, aliens.y, aliens.count * sizeof(int16_t));
+	out = put(out, aliens.type, aliens.count);
+	out = put(out, aliens.death_counter, aliens.count);
+	out = put(out, aliens.alive, (aliens.count + 63) / 64 * sizeof(uint64_t));
+	out = put(out, aliens.generation, aliens.count * sizeof(uint32_t));
+	pool_save(game.bullets, out);
+	return size;
+}
+
+// Whether the alien arrays of a blob hold a formation the game can draw:
+// known types and no alive bits past the last alien
+static bool aliens_valid(const uint8_t* in, size_t count)
+{
+	const uint8_t* type = in + 2 * align8(count * sizeof(int16_t));
+	for(size_t ai = 0; ai < count; ++ai)
+	{
+		if(type[ai] < ALIEN_TYPE_A || type[ai] > ALIEN_TYPE_C) return false;
+	}
+	if(count % 64 == 0) return true;
+	uint64_t last;
+	memcpy(&last, type + 2 * align8(count) + count / 64 * sizeof(uint64_t), sizeof(last));
+	return (last >> (count % 64)) == 0;
+}
+
+bool game_snapshot_load(Game* game, const void* blob, size_t size)
+{
+	GameSnapshotHeader header;
+	if(size < align8(sizeof(header))) return false;
+	memcpy(&header, blob, sizeof(header));
+	if(memcmp(header.magic, "SISS", 4) != 0 || header.version != GAME_SNAPSHOT_VERSION ||
+			header.size != size || header.num_aliens != game->aliens.count ||
+			header.bullet_size != sizeof(Bullet) ||
+			header.width != game->width || header.height != game->height)
+	{
+		return false;
+	}
+	// The march keeps the block on the screen, so it never moves it further than that
+	if(header.march_x < -(int64_t)header.width || header.march_x > (int64_t)header.width ||
+			header.march_y < -(int64_t)header.height || header.march_y > 0)
+	{
+		return false;
+	}
+	if((header.march_dir != 1 && header.march_dir != -1) || header.march_countdown == 0) return false;
+	for(size_t i = 0; i < 3; ++i)
+	{
+		const SpriteAnimation& animation = game->alien_animation[i];
+		if(header.animation_time[i] >= animation.num_frames * animation.frame_duration) return false;
+	}
+
+	// Everything after the header is checked before any of it is used
+	const uint8_t* aliens_in = (const uint8_t*)blob + align8(sizeof(header));
+	size_t aliens_bytes = aliens_size(header.num_aliens);
+	if(size - align8(sizeof(header)) < aliens_bytes) return false;
+	const uint8_t* bullets_in = aliens_in + aliens_bytes;
+	if(!aliens_valid(aliens_in, header.num_aliens) ||
+			!pool_snapshot_valid<Bullet>(bullets_in, size - align8(sizeof(header)) - aliens_bytes))
+	{
+		return false;
+	}
+
+	game->player.x = header.player_x;
+	game->player.y = header.player_y;
+	game->player.life = header.player_life;
+	game->score = header.score;
+	game->credits = header.credits;
+	for(size_t i = 0; i < 3; ++i)
+	{
+		game->alien_animation[i].time = header.animation_time[i];
+	}
+	game->march.x = header.march_x;
+	game->march.y = header.march_y;
+	game->march.dir = header.march_dir;
+	game->march.countdown = header.march_countdown;
+
+	AlienStore& aliens = game->aliens;
+	const uint8_t* in = aliens_in;
+	in = get(in, aliens.x, aliens.count * sizeof(int16_t));
+	in = get(in, aliens.y, aliens.count * sizeof(int16_t));
+	in = get(in, aliens.type, aliens.count);
+	in = get(in, aliens.death_counter, aliens.count);
+	in = get(in, aliens.alive, (aliens.count + 63) / 64 * sizeof(uint64_t));
+	in = get(in, aliens.generation, aliens.count * sizeof(uint32_t));
+	pool_load(&game->bullets, in);
+
+	// The grid and the march counts are derived from the aliens, refile
+	// the ones that are alive and count them again
+	for(size_t ai = 0; ai < aliens.count; ++ai)
+	{
+		if(alien_store_alive(aliens, ai)) spatial_grid_move(&game->alien_grid, ai, aliens.x[ai], aliens.y[ai]);
+		else spatial_grid_remove(&game->alien_grid, ai);
+	}
+	game_recount_aliens(game);
+	return true;
+}
+
+void snapshot_ring_init(SnapshotRing* ring, size_t capacity, size_t slot_size)
+{
+	ring->capacity = capacity;
+	ring->slot_size = align8(slot_size);
+	ring->slots = new uint8_t[ring->capacity * ring->slot_size];
+	ring->sizes = new size_t[ring->capacity];
+	ring->head = 0;
+	ring->count = 0;
+}
+
+void snapshot_ring_free(SnapshotRing* ring)
+{
+	delete[] ring->slots;
+	delete[] ring->sizes;
+	ring->capacity = ring->count = 0;
+}
+
+void snapshot_ring_push(SnapshotRing* ring, const Game& game)
+{
+	size_t size = game_snapshot_size(game);
+	if(size > ring->slot_size)
+	{
+		size_t slot_size = align8(size);
+		uint8_t* slots = new uint8_t[ring->capacity * slot_size];
+		for(size_t i = 0; i < ring->capacity; ++i)
+		{
+			memcpy(slots + i * slot_size, ring->slots + i * ring->slot_size, ring->slot_size);
+		}
+		delete[] ring->slots;
+		ring->slots = slots;
+		ring->slot_size = slot_size;
+	}
+
+	ring->sizes[ring->head] = game_snapshot_save(game, ring->slots + ring->head * ring->slot_size, ring->slot_size);
+	ring->head = (ring->head + 1) % ring->capacity;
+	if(ring->count < ring->capacity) ++ring->count;
+}
+
+bool snapshot_ring_rewind(SnapshotRing* ring, Game* game, size_t ticks_back)
+{
+	if(ticks_back >= ring->count) return false;
+	size_t slot = (ring->head + ring->capacity - 1 - ticks_back) % ring->capacity;
+	if(!game_snapshot_load(game, ring->slots + slot * ring->slot_size, ring->sizes[slot])) return false;
+	ring->head = (slot + 1) % ring->capacity;
+	ring->count -= ticks_back;
+	return true;
+}
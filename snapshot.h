@@ -0,0 +1,76 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include "game.h"
+
+#define GAME_SNAPSHOT_VERSION 2
+
+// Start of a snapshot blob. The blob holds the complete simulation state
+// of a Game and no pointers, so it can be copied around, written to a file
+// or mapped from one. After the header come the alien arrays, each padded
+// to 8 bytes, then the bullet pool as written by pool_save. Assets and
+// animation frames are not part of it: they come from the Game it is
+// loaded into
+struct GameSnapshotHeader
+{
+	// "SISS"
+	char magic[4];
+	uint32_t version;
+	// Bytes of the whole blob, header included
+	uint64_t size;
+	// Sizes the blob was written with, checked on load
+	uint32_t num_aliens;
+	uint32_t bullet_size;
+	uint64_t width, height;
+	uint64_t player_x, player_y, player_life;
+	uint64_t score, credits;
+	uint64_t animation_time[3];
+	// Where the formation has marched to, see AlienMarch. Its alien counts
+	// are derived from the alive bits
+	int32_t march_x, march_y;
+	int32_t march_dir;
+	uint32_t march_countdown;
+};
+
+// Bytes needed for a snapshot of the game as it is now
+size_t game_snapshot_size(const Game& game);
+
+// Write the snapshot into blob. Returns the bytes written, 0 if capacity is too small
+size_t game_snapshot_save(const Game& game, void* blob, size_t capacity);
+
+// Bring the game back to the state in the blob. The game must have been
+// initialized with the same assets and formation. Returns false, leaving
+// the game untouched, if the blob is not a snapshot of this version or
+// layout, or its contents are inconsistent: too short for the aliens, alien
+// types or alive bits out of range, or a bullet pool that fails
+// pool_snapshot_valid
+bool game_snapshot_load(Game* game, const void* blob, size_t size);
+
+// Snapshots of the last capacity ticks, for rollback and restarts.
+// Every slot has room for the largest snapshot seen so far, so pushing
+// only allocates when the bullet pool grows past the previous maximum
+struct SnapshotRing
+{
+	size_t capacity;
+	size_t slot_size;
+	uint8_t* slots;
+	size_t* sizes;
+	// Slot of the next push, and snapshots held
+	size_t head;
+	size_t count;
+};
+
+void snapshot_ring_init(SnapshotRing* ring, size_t capacity, size_t slot_size);
+void snapshot_ring_free(SnapshotRing* ring);
+
+// Save the game as the newest snapshot, dropping the oldest when full
+void snapshot_ring_push(SnapshotRing* ring, const Game& game);
+
+// Load the snapshot taken ticks_back pushes ago, 0 being the newest, and
+// drop the newer ones so that pushing continues from there.
+// Returns false if the ring does not reach that far back
+bool snapshot_ring_rewind(SnapshotRing* ring, Game* game, size_t ticks_back);
+
+#endif
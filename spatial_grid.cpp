@@ -0,0 +1,92 @@
+#include "spatial_grid.h"
+
+void spatial_grid_init(SpatialGrid* grid, Arena* arena, size_t num_items, size_t width, size_t height,
+		size_t cell_width, size_t cell_height)
+{
+	grid->cell_width = cell_width;
+	grid->cell_height = cell_height;
+	grid->columns = (width + cell_width - 1) / cell_width;
+	grid->rows = (height + cell_height - 1) / cell_height;
+	if(!grid->columns) grid->columns = 1;
+	if(!grid->rows) grid->rows = 1;
+	grid->num_items = num_items;
+
+	size_t num_cells = grid->columns * grid->rows;
+	grid->cell_head = arena_alloc_array<int32_t>(arena, num_cells);
+	for(size_t i = 0; i < num_cells; ++i)
+	{
+		grid->cell_head[i] = -1;
+	}
+
+	grid->next = arena_alloc_array<int32_t>(arena, num_items);
+	grid->prev = arena_alloc_array<int32_t>(arena, num_items);
+	grid->cell = arena_alloc_array<int32_t>(arena, num_items);
+	for(size_t i = 0; i < num_items; ++i)
+	{
+		grid->next[i] = grid->prev[i] = grid->cell[i] = -1;
+	}
+}
+
+static size_t grid_column(const SpatialGrid& grid, size_t x)
+{
+	size_t column = x / grid.cell_width;
+	return column < grid.columns? column: grid.columns - 1;
+}
+
+static size_t grid_row(const SpatialGrid& grid, size_t y)
+{
+	size_t row = y / grid.cell_height;
+	return row < grid.rows? row: grid.rows - 1;
+}
+
+static int32_t grid_cell(const SpatialGrid& grid, size_t x, size_t y)
+{
+	return grid_row(grid, y) * grid.columns + grid_column(grid, x);
+}
+
+static void link_item(SpatialGrid* grid, size_t item, int32_t cell)
+{
+	int32_t head = grid->cell_head[cell];
+	grid->next[item] = head;
+	grid->prev[item] = -1;
+	if(head >= 0) grid->prev[head] = item;
+	grid->cell_head[cell] = item;
+	grid->cell[item] = cell;
+}
+
+void spatial_grid_insert(SpatialGrid* grid, size_t item, size_t x, size_t y)
+{
+	link_item(grid, item, grid_cell(*grid, x, y));
+}
+
+void spatial_grid_remove(SpatialGrid* grid, size_t item)
+{
+	int32_t cell = grid->cell[item];
+	if(cell < 0) return;
+
+	int32_t next = grid->next[item];
+	int32_t prev = grid->prev[item];
+	if(prev >= 0) grid->next[prev] = next;
+	else grid->cell_head[cell] = next;
+	if(next >= 0) grid->prev[next] = prev;
+
+	grid->next[item] = grid->prev[item] = grid->cell[item] = -1;
+}
+
+void spatial_grid_move(SpatialGrid* grid, size_t item, size_t x, size_t y)
+{
+	int32_t cell = grid_cell(*grid, x, y);
+	if(cell == grid->cell[item]) return;
+	spatial_grid_remove(grid, item);
+	link_item(grid, item, cell);
+}
+
+void spatial_grid_cells(const SpatialGrid& grid, const Rect& rect,
+		size_t* column_begin, size_t* column_end, size_t* row_begin, size_t* row_end)
+{
+	// Items filed up to one cell left of or below the rectangle can reach into it
+	*column_begin = grid_column(grid, rect.x0 >= grid.cell_width? rect.x0 - grid.cell_width + 1: 0);
+	*column_end = grid_column(grid, rect.x1 - 1);
+	*row_begin = grid_row(grid, rect.y0 >= grid.cell_height? rect.y0 - grid.cell_height + 1: 0);
+	*row_end = grid_row(grid, rect.y1 - 1);
+}
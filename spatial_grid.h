@@ -0,0 +1,63 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include "buffer.h"
+#include "arena.h"
+
+// Broad phase for collisions: a uniform grid where every item is filed in
+// the cell holding its bottom-left corner. Cells are at least as large as
+// the largest item, so a query only has to look one cell further left and
+// down than the area it covers. Items are kept in intrusive linked lists,
+// so inserting, removing and moving an item is O(1) and never allocates
+struct SpatialGrid
+{
+	size_t cell_width, cell_height;
+	size_t columns, rows;
+	// First item of each cell, -1 if empty
+	int32_t* cell_head;
+	// Per item: neighbours in the list of its cell, and that cell (-1 if not in the grid)
+	int32_t* next;
+	int32_t* prev;
+	int32_t* cell;
+	size_t num_items;
+};
+
+// Grid covering [0, width) x [0, height) for items 0 to num_items - 1.
+// Positions outside the area are clamped to the border cells. The lists
+// are allocated from the arena and live as long as it does
+void spatial_grid_init(SpatialGrid* grid, Arena* arena, size_t num_items, size_t width, size_t height,
+		size_t cell_width, size_t cell_height);
+
+void spatial_grid_insert(SpatialGrid* grid, size_t item, size_t x, size_t y);
+void spatial_grid_remove(SpatialGrid* grid, size_t item);
+// Only relinks the item if it changes cell
+void spatial_grid_move(SpatialGrid* grid, size_t item, size_t x, size_t y);
+
+// Cell range of the items that may overlap the rectangle
+void spatial_grid_cells(const SpatialGrid& grid, const Rect& rect,
+		size_t* column_begin, size_t* column_end, size_t* row_begin, size_t* row_end);
+
+// Call visit(item) for every item that may overlap the rectangle.
+// Callers do the exact overlap test
+template<typename Visit>
+void spatial_grid_query(const SpatialGrid& grid, const Rect& rect, Visit visit)
+{
+	if(rect.x0 >= rect.x1 || rect.y0 >= rect.y1) return;
+
+	size_t column_begin, column_end, row_begin, row_end;
+	spatial_grid_cells(grid, rect, &column_begin, &column_end, &row_begin, &row_end);
+	for(size_t row = row_begin; row <= row_end; ++row)
+	{
+		for(size_t column = column_begin; column <= column_end; ++column)
+		{
+			for(int32_t item = grid.cell_head[row * grid.columns + column]; item >= 0; item = grid.next[item])
+			{
+				visit((size_t)item);
+			}
+		}
+	}
+}
+
+#endif
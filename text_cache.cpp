@@ -0,0 +1,156 @@
+#include <cassert>
+#include <cstring>
+#include "text_cache.h"
+
+static_assert(TEXT_CACHE_SIZE <= 32, "the masks of TextCache have a bit per entry");
+
+void text_cache_init(TextCache* cache, Arena* arena)
+{
+	cache->arena = arena;
+	for(size_t i = 0; i < TEXT_CACHE_SIZE; ++i)
+	{
+		CachedText& entry = cache->entries[i];
+		entry.text[0] = '\0';
+		entry.spritesheet = NULL;
+		entry.num_strips = 0;
+		entry.strips = NULL;
+		entry.rows = NULL;
+		entry.rows_capacity = entry.strips_capacity = 0;
+		entry.last_used = 0;
+	}
+	cache->num_entries = 0;
+	cache->clock = 0;
+	cache->drawn = cache->pinned = 0;
+	cache->hits = cache->misses = 0;
+}
+
+// Composite the glyphs of the entry's text into its strips
+static void cached_text_rasterize(CachedText* entry, Arena* arena)
+{
+	const Sprite& spritesheet = *entry->spritesheet;
+	size_t height = spritesheet.height;
+	size_t advance = spritesheet.width + 1;
+
+	size_t num_glyphs = 0;
+	for(const char* charp = entry->text; *charp != '\0'; ++charp)
+	{
+		char character = *charp - 32;
+		if(character >= 0 && character < 65) ++num_glyphs;
+	}
+	entry->width = num_glyphs? num_glyphs * advance - 1: 0;
+	entry->height = height;
+	entry->num_strips = (entry->width + SPRITE_MAX_WIDTH - 1) / SPRITE_MAX_WIDTH;
+
+	if(entry->num_strips > entry->strips_capacity)
+	{
+		entry->strips_capacity = entry->num_strips;
+		entry->strips = arena_alloc_array<Sprite>(arena, entry->strips_capacity);
+	}
+	size_t num_rows = entry->num_strips * height;
+	if(num_rows > entry->rows_capacity)
+	{
+		entry->rows_capacity = num_rows;
+		entry->rows = arena_alloc_array<uint32_t>(arena, entry->rows_capacity);
+	}
+	memset(entry->rows, 0, num_rows * sizeof(uint32_t));
+
+	// A glyph starting near the end of a strip spills into the next one
+	size_t x = 0;
+	for(const char* charp = entry->text; *charp != '\0'; ++charp)
+	{
+		char character = *charp - 32;
+		if(character < 0 || character >= 65) continue;
+		const uint32_t* glyph = spritesheet.rows + character * height;
+		size_t strip = x / SPRITE_MAX_WIDTH;
+		size_t shift = x % SPRITE_MAX_WIDTH;
+		uint32_t* rows = entry->rows + strip * height;
+		for(size_t yi = 0; yi < height; ++yi)
+		{
+			rows[yi] |= glyph[yi] << shift;
+			if(shift + spritesheet.width > SPRITE_MAX_WIDTH)
+			{
+				rows[height + yi] |= glyph[yi] >> (SPRITE_MAX_WIDTH - shift);
+			}
+		}
+		x += advance;
+	}
+
+	for(size_t s = 0; s < entry->num_strips; ++s)
+	{
+		Sprite& sprite = entry->strips[s];
+		size_t strip_x = s * SPRITE_MAX_WIDTH;
+		sprite.width = entry->width - strip_x < SPRITE_MAX_WIDTH? entry->width - strip_x: SPRITE_MAX_WIDTH;
+		sprite.height = height;
+		sprite.data = NULL;
+		sprite.rows = entry->rows + s * height;
+	}
+}
+
+const CachedText* text_cache_get(TextCache* cache, const Sprite& spritesheet, const char* text)
+{
+	for(size_t i = 0; i < cache->num_entries; ++i)
+	{
+		CachedText& entry = cache->entries[i];
+		if(entry.spritesheet == &spritesheet && strncmp(entry.text, text, TEXT_CACHE_MAX_LENGTH) == 0)
+		{
+			++cache->hits;
+			return &entry;
+		}
+	}
+
+	CachedText* entry;
+	if(cache->num_entries < TEXT_CACHE_SIZE)
+	{
+		entry = &cache->entries[cache->num_entries++];
+	}
+	else
+	{
+		entry = NULL;
+		for(size_t i = 0; i < TEXT_CACHE_SIZE; ++i)
+		{
+			if((cache->pinned >> i) & 1) continue;
+			if(!entry || cache->entries[i].last_used < entry->last_used) entry = &cache->entries[i];
+		}
+		assert(entry);
+	}
+	++cache->misses;
+
+	strncpy(entry->text, text, TEXT_CACHE_MAX_LENGTH);
+	entry->text[TEXT_CACHE_MAX_LENGTH] = '\0';
+	entry->spritesheet = &spritesheet;
+	entry->last_used = ++cache->clock;
+	cached_text_rasterize(entry, cache->arena);
+	return entry;
+}
+
+void text_cache_forget(TextCache* cache, const Sprite& spritesheet)
+{
+	for(size_t i = 0; i < cache->num_entries; ++i)
+	{
+		if(cache->entries[i].spritesheet == &spritesheet) cache->entries[i].spritesheet = NULL;
+	}
+}
+
+void text_cache_draw(TextCache* cache, DrawList* list, const CachedText* text,
+		size_t x, size_t y, uint32_t color)
+{
+	size_t i = text - cache->entries;
+	cache->entries[i].last_used = ++cache->clock;
+	cache->drawn |= (uint32_t)1 << i;
+	for(size_t s = 0; s < text->num_strips; ++s)
+	{
+		draw_list_sprite(list, text->strips[s], x + s * SPRITE_MAX_WIDTH, y, color);
+	}
+}
+
+uint32_t text_cache_take_drawn(TextCache* cache)
+{
+	uint32_t drawn = cache->drawn;
+	cache->drawn = 0;
+	return drawn;
+}
+
+void text_cache_pin(TextCache* cache, uint32_t entries)
+{
+	cache->pinned = entries;
+}
@@ -0,0 +1,78 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "arena.h"
+#include "buffer.h"
+#include "draw_list.h"
+
+// Strings the cache holds at once, the least recently drawn one is replaced
+#define TEXT_CACHE_SIZE 16
+// Longer strings are cut
+#define TEXT_CACHE_MAX_LENGTH 31
+
+// A string rasterized once from a spritesheet. The glyphs are composited
+// into strips of up to SPRITE_MAX_WIDTH columns, left to right, so the
+// whole string is drawn with one row mask per strip row instead of one
+// sprite per character
+struct CachedText
+{
+	// Key of the entry, along with the spritesheet
+	char text[TEXT_CACHE_MAX_LENGTH + 1];
+	const Sprite* spritesheet;
+	size_t width, height;
+	size_t num_strips;
+	Sprite* strips;
+	// Row masks of the strips, one strip after the other
+	uint32_t* rows;
+	size_t rows_capacity;
+	size_t strips_capacity;
+	uint64_t last_used;
+};
+
+// Rendered strings keyed by content. An entry keeps its row masks until it
+// is replaced by another string, the least recently drawn entry that is not
+// pinned. The draw lists holding an entry pin it until they are done with,
+// so that its rows neither change under a renderer nor, for DirtyTracker,
+// come to stand for another string at the same address
+struct TextCache
+{
+	// Holds the strips and row masks. Storage an entry outgrows is left in
+	// the arena, which only happens until each entry has held its longest string
+	Arena* arena;
+	CachedText entries[TEXT_CACHE_SIZE];
+	size_t num_entries;
+	uint64_t clock;
+	// Bit i stands for entry i: those drawn since text_cache_take_drawn, and
+	// those text_cache_get must not replace
+	uint32_t drawn;
+	uint32_t pinned;
+	// Lookups found in the cache and rasterized into it
+	size_t hits, misses;
+};
+
+void text_cache_init(TextCache* cache, Arena* arena);
+
+// The string rendered with the spritesheet, from the cache or rasterized into
+// it. Characters outside the spritesheet are skipped, as in draw_list_text.
+// At most TEXT_CACHE_SIZE - 1 entries can be pinned
+const CachedText* text_cache_get(TextCache* cache, const Sprite& spritesheet, const char* text);
+
+// Stop finding the strings rasterized from spritesheet, whose glyphs
+// changed. Their entries are still replaced in turn like any other, so the
+// draw lists holding them stay valid
+void text_cache_forget(TextCache* cache, const Sprite& spritesheet);
+
+// Record the strips of a cached string, which counts as a use of the entry
+void text_cache_draw(TextCache* cache, DrawList* list, const CachedText* text,
+		size_t x, size_t y, uint32_t color);
+
+// The entries drawn since the last call, to pin while a list drawn in
+// between is in use
+uint32_t text_cache_take_drawn(TextCache* cache);
+
+// Keep the entries of the mask from being replaced, until the next call
+void text_cache_pin(TextCache* cache, uint32_t entries);
+
+#endif
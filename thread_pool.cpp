@@ -0,0 +1,155 @@
+#include "thread_pool.h"
+
+static uint64_t pack_range(uint64_t begin, uint64_t end)
+{
+	return begin | (end << 32);
+}
+
+// Take the first index of the thread's own range
+static bool take_own(std::atomic<uint64_t>* range, size_t* index)
+{
+	uint64_t current = range->load();
+	for(;;)
+	{
+		uint64_t begin = current & 0xffffffff, end = current >> 32;
+		if(begin >= end) return false;
+		if(range->compare_exchange_weak(current, pack_range(begin + 1, end)))
+		{
+			*index = begin;
+			return true;
+		}
+	}
+}
+
+// Take the back half of another thread's range: its first index is run
+// right away and the rest becomes the thief's own range
+static bool steal(ThreadPool* pool, size_t thread, size_t* index)
+{
+	size_t num_threads = pool->num_workers + 1;
+	for(size_t i = 1; i < num_threads; ++i)
+	{
+		std::atomic<uint64_t>* victim = &pool->ranges[((thread + i) % num_threads) * THREAD_POOL_RANGE_STRIDE];
+		uint64_t current = victim->load();
+		for(;;)
+		{
+			uint64_t begin = current & 0xffffffff, end = current >> 32;
+			if(begin >= end) break;
+			uint64_t middle = begin + (end - begin) / 2;
+			if(victim->compare_exchange_weak(current, pack_range(begin, middle)))
+			{
+				// The own range is empty, so no other thread writes it now
+				pool->ranges[thread * THREAD_POOL_RANGE_STRIDE].store(pack_range(middle + 1, end));
+				pool->steals += end - middle;
+				*index = middle;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static void thread_pool_work(ThreadPool* pool, size_t thread)
+{
+	std::atomic<uint64_t>* range = &pool->ranges[thread * THREAD_POOL_RANGE_STRIDE];
+	size_t index;
+	while(take_own(range, &index) || steal(pool, thread, &index))
+	{
+		pool->task(pool->context, index);
+	}
+}
+
+static void thread_pool_worker(ThreadPool* pool, size_t thread)
+{
+	uint64_t job = 0;
+	for(;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(pool->mutex);
+			pool->wake.wait(lock, [&]{ return pool->quit || pool->job != job; });
+			if(pool->quit) return;
+			job = pool->job;
+		}
+
+		thread_pool_work(pool, thread);
+
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		if(--pool->busy == 0) pool->done.notify_one();
+	}
+}
+
+void thread_pool_init(ThreadPool* pool, size_t num_threads)
+{
+	pool->num_workers = num_threads > 1? num_threads - 1: 0;
+	pool->task = NULL;
+	pool->context = NULL;
+	pool->ranges = new std::atomic<uint64_t>[(pool->num_workers + 1) * THREAD_POOL_RANGE_STRIDE];
+	for(size_t t = 0; t <= pool->num_workers; ++t)
+	{
+		pool->ranges[t * THREAD_POOL_RANGE_STRIDE] = 0;
+	}
+	pool->steals = 0;
+	pool->busy = 0;
+	pool->job = 0;
+	pool->quit = false;
+	pool->workers = new std::thread[pool->num_workers];
+	for(size_t i = 0; i < pool->num_workers; ++i)
+	{
+		pool->workers[i] = std::thread(thread_pool_worker, pool, i + 1);
+	}
+}
+
+void thread_pool_free(ThreadPool* pool)
+{
+	{
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		pool->quit = true;
+	}
+	pool->wake.notify_all();
+	for(size_t i = 0; i < pool->num_workers; ++i)
+	{
+		pool->workers[i].join();
+	}
+	delete[] pool->workers;
+	delete[] pool->ranges;
+	pool->workers = NULL;
+	pool->ranges = NULL;
+	pool->num_workers = 0;
+}
+
+size_t thread_pool_hardware_threads()
+{
+	size_t num_threads = std::thread::hardware_concurrency();
+	return num_threads? num_threads: 1;
+}
+
+void thread_pool_run(ThreadPool* pool, size_t count, void (*task)(void* context, size_t index), void* context)
+{
+	if(!pool->num_workers || count <= 1)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			task(context, i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		pool->task = task;
+		pool->context = context;
+		size_t num_threads = pool->num_workers + 1;
+		for(size_t t = 0; t < num_threads; ++t)
+		{
+			pool->ranges[t * THREAD_POOL_RANGE_STRIDE] = pack_range(count * t / num_threads, count * (t + 1) / num_threads);
+		}
+		pool->busy = pool->num_workers;
+		++pool->job;
+	}
+	pool->wake.notify_all();
+
+	thread_pool_work(pool, 0);
+
+	// Workers may still be running their last index
+	std::unique_lock<std::mutex> lock(pool->mutex);
+	pool->done.wait(lock, [&]{ return pool->busy == 0; });
+}
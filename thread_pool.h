@@ -0,0 +1,68 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Spacing of the per-thread ranges, 64 bytes apart
+#define THREAD_POOL_RANGE_STRIDE 8
+
+// Fixed set of worker threads that run the indices of one job at a time.
+// The thread that starts a job works on it too. Each thread starts with a
+// contiguous share of the indices and takes them from the front; a thread
+// that runs out steals the back half of another thread's remaining range,
+// so uneven tasks still balance while threads mostly touch their own data
+struct ThreadPool
+{
+	// Worker threads, not counting the thread that runs the jobs
+	size_t num_workers;
+	std::thread* workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	// Current job
+	void (*task)(void* context, size_t index);
+	void* context;
+	// Indices left to each thread, begin in the low 32 bits and end in the
+	// high 32 bits, so that both can be updated with one compare and swap.
+	// Thread t uses entry t * THREAD_POOL_RANGE_STRIDE, on its own cache
+	// line; thread 0 is the one running the job
+	std::atomic<uint64_t>* ranges;
+	// Indices taken from another thread's range
+	std::atomic<size_t> steals;
+	// Workers that have not finished the current job yet
+	size_t busy;
+	// Incremented for every job, workers wait for it to change
+	uint64_t job;
+	bool quit;
+};
+
+// Pool where jobs run on num_threads threads in total, the caller included.
+// With 1 thread or less jobs run serially on the caller
+void thread_pool_init(ThreadPool* pool, size_t num_threads);
+void thread_pool_free(ThreadPool* pool);
+
+// Number of threads the hardware runs at once, at least 1
+size_t thread_pool_hardware_threads();
+
+// Call task(context, i) for i in [0, count) and return once all have finished
+void thread_pool_run(ThreadPool* pool, size_t count, void (*task)(void* context, size_t index), void* context);
+
+template<typename Function>
+void parallel_for_task(void* context, size_t index)
+{
+	(*(Function*)context)(index);
+}
+
+// Call function(i) for i in [0, count) on the pool
+template<typename Function>
+void parallel_for(ThreadPool* pool, size_t count, Function function)
+{
+	thread_pool_run(pool, count, parallel_for_task<Function>, &function);
+}
+
+#endif
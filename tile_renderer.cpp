@@ -0,0 +1,80 @@
+#include <cstring>
+#include "tile_renderer.h"
+#include "profiler.h"
+
+void tile_renderer_init(TileRenderer* renderer, ThreadPool* pool, size_t height, size_t band_height)
+{
+	renderer->pool = pool;
+	renderer->band_height = band_height? band_height: 1;
+	renderer->num_bands = (height + renderer->band_height - 1) / renderer->band_height;
+}
+
+// Bands [*band_begin, *band_end) covered by the command, an empty range if none
+static void command_bands(const TileRenderer& renderer, const Buffer& buffer, const DrawCommand& command,
+		size_t num_bands, size_t* band_begin, size_t* band_end)
+{
+	Rect rect = draw_command_rect(command);
+	*band_begin = *band_end = 0;
+	if(rect.y0 >= buffer.height || rect.y0 >= rect.y1) return;
+	*band_begin = rect.y0 / renderer.band_height;
+	*band_end = (rect.y1 - 1) / renderer.band_height + 1;
+	if(*band_end > num_bands) *band_end = num_bands;
+}
+
+void tile_renderer_render(TileRenderer* renderer, Buffer* buffer, const DrawList& list, Arena* scratch)
+{
+	size_t num_bands = (buffer->height + renderer->band_height - 1) / renderer->band_height;
+	if(num_bands > renderer->num_bands) num_bands = renderer->num_bands;
+
+	// Binning is serial and cheap next to the drawing: the commands are
+	// counted per band, then their indices are laid out band after band.
+	// Band b holds band_commands[band_offsets[b]] to band_commands[band_offsets[b + 1]]
+	size_t* band_offsets = arena_alloc_array<size_t>(scratch, num_bands + 1);
+	uint32_t* band_commands;
+	{
+		PROFILE_SCOPE("bin");
+		memset(band_offsets, 0, (num_bands + 1) * sizeof(size_t));
+		for(size_t i = 0; i < list.num_commands; ++i)
+		{
+			size_t band_begin, band_end;
+			command_bands(*renderer, *buffer, list.commands[i], num_bands, &band_begin, &band_end);
+			for(size_t b = band_begin; b < band_end; ++b)
+			{
+				++band_offsets[b];
+			}
+		}
+		// Running sum: each offset becomes the end of its band for now
+		for(size_t b = 1; b < num_bands; ++b)
+		{
+			band_offsets[b] += band_offsets[b - 1];
+		}
+		band_offsets[num_bands] = num_bands? band_offsets[num_bands - 1]: 0;
+
+		// Filled back to front so that each offset ends up at the start of its band
+		band_commands = arena_alloc_array<uint32_t>(scratch, band_offsets[num_bands]);
+		for(size_t i = list.num_commands; i-- > 0;)
+		{
+			size_t band_begin, band_end;
+			command_bands(*renderer, *buffer, list.commands[i], num_bands, &band_begin, &band_end);
+			for(size_t b = band_begin; b < band_end; ++b)
+			{
+				band_commands[--band_offsets[b]] = i;
+			}
+		}
+	}
+
+	parallel_for(renderer->pool, num_bands, [&](size_t b)
+	{
+		PROFILE_SCOPE("band");
+		size_t y0 = b * renderer->band_height;
+		size_t y1 = y0 + renderer->band_height;
+		if(y1 > buffer->height) y1 = buffer->height;
+		Rect clip = {0, y0, buffer->width, y1};
+
+		buffer_fill_rect(buffer, clip, draw_list_pixel(*buffer, list.palette, list.clear_color));
+		for(size_t i = band_offsets[b]; i < band_offsets[b + 1]; ++i)
+		{
+			draw_command_render(buffer, list.commands[band_commands[i]], clip, list.palette);
+		}
+	});
+}
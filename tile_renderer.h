@@ -0,0 +1,32 @@
+#ifndef TILE_RENDERER_H
+#define TILE_RENDERER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "arena.h"
+#include "buffer.h"
+#include "draw_list.h"
+#include "thread_pool.h"
+
+// Default height of a band in rows
+#define TILE_BAND_HEIGHT 16
+
+// Draws a DrawList on a thread pool. The buffer is split into bands of
+// rows, every command is binned into the bands it covers, then each band
+// is cleared and drawn by one thread. A band draws its commands in list
+// order, clipped to the band, so the result is the same as draw_list_render
+struct TileRenderer
+{
+	ThreadPool* pool;
+	size_t band_height;
+	size_t num_bands;
+};
+
+void tile_renderer_init(TileRenderer* renderer, ThreadPool* pool, size_t height,
+		size_t band_height = TILE_BAND_HEIGHT);
+
+// Same as draw_list_render. The bins are allocated from scratch, which the
+// caller resets once the frame is drawn
+void tile_renderer_render(TileRenderer* renderer, Buffer* buffer, const DrawList& list, Arena* scratch);
+
+#endif
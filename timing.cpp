@@ -0,0 +1,60 @@
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include "timing.h"
+
+void frame_pacer_init(FramePacer* pacer, double fps)
+{
+	pacer->period_ns = fps > 0? (uint64_t)(1e9 / fps): 0;
+	pacer->spin_ns = 2000000;
+	pacer->next_frame_ns = time_ns() + pacer->period_ns;
+	pacer->last_frame_ns = 0;
+	pacer->frames = 0;
+	pacer->sum_ns = 0;
+	pacer->sum_sq_ns = 0;
+	pacer->min_ns = UINT64_MAX;
+	pacer->max_ns = 0;
+}
+
+void frame_pacer_wait(FramePacer* pacer)
+{
+	uint64_t now = time_ns();
+	if(pacer->period_ns)
+	{
+		uint64_t deadline = pacer->next_frame_ns;
+		if(now + pacer->spin_ns < deadline)
+		{
+			std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now - pacer->spin_ns));
+		}
+		while((now = time_ns()) < deadline) {}
+
+		// After falling more than a frame behind, pace from now
+		// instead of running a burst of frames to catch up
+		pacer->next_frame_ns += pacer->period_ns;
+		if(pacer->next_frame_ns + pacer->period_ns < now)
+		{
+			pacer->next_frame_ns = now + pacer->period_ns;
+		}
+	}
+
+	if(pacer->last_frame_ns)
+	{
+		uint64_t interval = now - pacer->last_frame_ns;
+		++pacer->frames;
+		pacer->sum_ns += interval;
+		pacer->sum_sq_ns += (double)interval * interval;
+		if(interval < pacer->min_ns) pacer->min_ns = interval;
+		if(interval > pacer->max_ns) pacer->max_ns = interval;
+	}
+	pacer->last_frame_ns = now;
+}
+
+void frame_pacer_print_stats(const FramePacer& pacer)
+{
+	if(!pacer.frames) return;
+	double mean = pacer.sum_ns / pacer.frames;
+	double variance = pacer.sum_sq_ns / pacer.frames - mean * mean;
+	double jitter = variance > 0? sqrt(variance): 0;
+	printf("Frame interval: %.3f ms mean, %.3f ms jitter (std dev), %.3f ms min, %.3f ms max\n",
+			mean / 1e6, jitter / 1e6, pacer.min_ns / 1e6, pacer.max_ns / 1e6);
+}
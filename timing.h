@@ -0,0 +1,42 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Monotonic time in nanoseconds
+inline uint64_t time_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Holds frames to a target rate by sleeping until shortly before the
+// deadline and spinning for the rest, which the OS scheduler cannot do
+// precisely on its own. Also keeps statistics of the frame intervals
+struct FramePacer
+{
+	// Target frame time, 0 to not wait at all
+	uint64_t period_ns;
+	// Sleep until this long before the deadline, then spin
+	uint64_t spin_ns;
+	uint64_t next_frame_ns;
+	uint64_t last_frame_ns;
+	// Frame interval statistics
+	size_t frames;
+	double sum_ns;
+	double sum_sq_ns;
+	uint64_t min_ns;
+	uint64_t max_ns;
+};
+
+// fps of 0 disables waiting but still records the intervals
+void frame_pacer_init(FramePacer* pacer, double fps);
+
+// Wait for the deadline of the next frame and record the interval since the last one
+void frame_pacer_wait(FramePacer* pacer);
+
+void frame_pacer_print_stats(const FramePacer& pacer);
+
+#endif
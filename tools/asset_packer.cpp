@@ -0,0 +1,301 @@
+// Builds an asset pack (see asset_pack.h) from its text description, such as
+// assets/game_assets.txt:
+//   asset_packer SOURCE PACK
+// The pack is written next to PACK and renamed over it once complete and
+// checked, so that a game mapping the old pack never sees it truncated
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "../asset_pack.h"
+
+static const char* sprite_names[NUM_ASSET_SPRITES] =
+{
+	"alien_a0", "alien_a1", "alien_b0", "alien_b1", "alien_c0", "alien_c1",
+	"alien_death", "player", "bullet", "text"
+};
+
+struct PackerSprite
+{
+	size_t width, height, frames;
+	// Row masks, frames * height of them
+	uint32_t* rows;
+};
+
+struct Packer
+{
+	const char* path;
+	size_t line;
+	PackerSprite sprites[NUM_ASSET_SPRITES];
+	AssetAnimation animations[3];
+	AssetFormation formation;
+	bool has_formation, has_rows;
+};
+
+static void packer_error(const Packer& packer, const char* message)
+{
+	fprintf(stderr, "%s:%lu: %s\n", packer.path, packer.line, message);
+	exit(1);
+}
+
+// Next line that is not blank or a comment, without its newline
+static bool packer_next_line(Packer* packer, FILE* file, char* line, size_t size)
+{
+	while(fgets(line, size, file))
+	{
+		++packer->line;
+		line[strcspn(line, "\r\n")] = '\0';
+		if(line[0] != '\0' && line[0] != '#') return true;
+	}
+	return false;
+}
+
+static int packer_sprite_index(const char* name)
+{
+	for(int i = 0; i < NUM_ASSET_SPRITES; ++i)
+	{
+		if(strcmp(sprite_names[i], name) == 0) return i;
+	}
+	return -1;
+}
+
+// Alien type of a, b or c, or 0
+static uint8_t packer_alien_type(const char* name)
+{
+	if(strlen(name) != 1 || name[0] < 'a' || name[0] > 'c') return 0;
+	return name[0] - 'a' + 1;
+}
+
+static void packer_read_sprite(Packer* packer, FILE* file, char* line, size_t size)
+{
+	char name[64];
+	unsigned long width, height, frames = 1;
+	int fields = sscanf(line, "sprite %63s %lu %lu %lu", name, &width, &height, &frames);
+	if(fields < 3) packer_error(*packer, "expected: sprite NAME WIDTH HEIGHT [FRAMES]");
+	int index = packer_sprite_index(name);
+	if(index < 0) packer_error(*packer, "unknown sprite name");
+	PackerSprite& sprite = packer->sprites[index];
+	if(sprite.rows) packer_error(*packer, "sprite defined twice");
+	if(width == 0 || width > SPRITE_MAX_WIDTH || height == 0 || frames == 0 || height * frames > 0xffff)
+	{
+		packer_error(*packer, "bad sprite size");
+	}
+
+	sprite.width = width;
+	sprite.height = height;
+	sprite.frames = frames;
+	sprite.rows = new uint32_t[frames * height];
+	for(size_t r = 0; r < frames * height; ++r)
+	{
+		if(!packer_next_line(packer, file, line, size)) packer_error(*packer, "sprite rows missing");
+		if(strlen(line) != width || strspn(line, ".@") != width) packer_error(*packer, "bad sprite row");
+		uint32_t mask = 0;
+		for(size_t i = 0; i < width; ++i)
+		{
+			if(line[i] == '@') mask |= (uint32_t)1 << i;
+		}
+		sprite.rows[r] = mask;
+	}
+}
+
+static void packer_read_animation(Packer* packer, char* line)
+{
+	char* token = strtok(line, " \t");
+	char* type_name = strtok(NULL, " \t");
+	char* duration = strtok(NULL, " \t");
+	uint8_t type = type_name? packer_alien_type(type_name): 0;
+	if(!type || !duration || atoi(duration) < 1 || atoi(duration) > 255)
+	{
+		packer_error(*packer, "expected: animation a|b|c DURATION SPRITE...");
+	}
+	AssetAnimation& animation = packer->animations[type - 1];
+	if(animation.num_frames) packer_error(*packer, "animation defined twice");
+	animation.frame_duration = atoi(duration);
+	while((token = strtok(NULL, " \t")))
+	{
+		int index = packer_sprite_index(token);
+		if(index < ASSET_SPRITE_ALIEN_A0 || index > ASSET_SPRITE_ALIEN_C1) packer_error(*packer, "not an alien sprite");
+		if(animation.num_frames == ASSET_MAX_ANIMATION_FRAMES) packer_error(*packer, "too many frames");
+		animation.frames[animation.num_frames++] = index - ASSET_SPRITE_ALIEN_A0;
+	}
+	if(!animation.num_frames) packer_error(*packer, "animation without frames");
+}
+
+static void packer_read_rows(Packer* packer, char* line)
+{
+	if(!packer->has_formation) packer_error(*packer, "rows before formation");
+	if(packer->has_rows) packer_error(*packer, "rows given twice");
+	size_t num_rows = 0;
+	strtok(line, " \t");
+	for(char* token; (token = strtok(NULL, " \t"));)
+	{
+		uint8_t type = packer_alien_type(token);
+		if(!type) packer_error(*packer, "row type must be a, b or c");
+		if(num_rows == packer->formation.rows) packer_error(*packer, "more row types than rows");
+		packer->formation.row_types[num_rows++] = type;
+	}
+	if(num_rows != packer->formation.rows) packer_error(*packer, "fewer row types than rows");
+	packer->has_rows = true;
+}
+
+static void packer_read(Packer* packer, FILE* file)
+{
+	char line[256];
+	while(packer_next_line(packer, file, line, sizeof(line)))
+	{
+		if(strncmp(line, "sprite ", 7) == 0)
+		{
+			packer_read_sprite(packer, file, line, sizeof(line));
+		}
+		else if(strncmp(line, "animation ", 10) == 0)
+		{
+			packer_read_animation(packer, line);
+		}
+		else if(strncmp(line, "formation ", 10) == 0)
+		{
+			unsigned columns, rows, x, y, dx, dy;
+			if(sscanf(line, "formation %u %u %u %u %u %u", &columns, &rows, &x, &y, &dx, &dy) != 6 ||
+					columns == 0 || columns > 0xffff || rows == 0 || rows > ASSET_MAX_FORMATION_ROWS ||
+					x > 0xffff || y > 0xffff || dx > 0xffff || dy > 0xffff)
+			{
+				packer_error(*packer, "expected: formation COLUMNS ROWS X Y DX DY");
+			}
+			if(packer->has_formation) packer_error(*packer, "formation given twice");
+			AssetFormation& formation = packer->formation;
+			formation.columns = columns;
+			formation.rows = rows;
+			formation.x = x;
+			formation.y = y;
+			formation.dx = dx;
+			formation.dy = dy;
+			packer->has_formation = true;
+		}
+		else if(strncmp(line, "rows ", 5) == 0)
+		{
+			packer_read_rows(packer, line);
+		}
+		else
+		{
+			packer_error(*packer, "unknown statement");
+		}
+	}
+
+	for(size_t i = 0; i < NUM_ASSET_SPRITES; ++i)
+	{
+		if(!packer->sprites[i].rows)
+		{
+			fprintf(stderr, "%s: sprite %s missing\n", packer->path, sprite_names[i]);
+			exit(1);
+		}
+	}
+	if(packer->sprites[ASSET_SPRITE_TEXT].frames != 65)
+	{
+		fprintf(stderr, "%s: the font needs 65 glyphs\n", packer->path);
+		exit(1);
+	}
+	for(size_t i = 0; i < 3; ++i)
+	{
+		if(!packer->animations[i].num_frames)
+		{
+			fprintf(stderr, "%s: animation of alien type %c missing\n", packer->path, (char)('a' + i));
+			exit(1);
+		}
+	}
+	if(!packer->has_formation || !packer->has_rows)
+	{
+		fprintf(stderr, "%s: formation or its rows missing\n", packer->path);
+		exit(1);
+	}
+}
+
+// The pack as it is laid out in the file
+static uint8_t* packer_build(const Packer& packer, size_t* size)
+{
+	size_t sprites_offset = sizeof(AssetPackHeader);
+	size_t animations_offset = sprites_offset + NUM_ASSET_SPRITES * sizeof(AssetPackSprite);
+	size_t formation_offset = (animations_offset + sizeof(packer.animations) + 3) & ~(size_t)3;
+	size_t rows_offset = (formation_offset + sizeof(AssetFormation) + 3) & ~(size_t)3;
+	*size = rows_offset;
+	for(size_t i = 0; i < NUM_ASSET_SPRITES; ++i)
+	{
+		*size += packer.sprites[i].frames * packer.sprites[i].height * sizeof(uint32_t);
+	}
+
+	uint8_t* data = new uint8_t[*size];
+	memset(data, 0, *size);
+	AssetPackHeader& header = *(AssetPackHeader*)data;
+	memcpy(header.magic, "SIAP", 4);
+	header.version = ASSET_PACK_VERSION;
+	header.num_sprites = NUM_ASSET_SPRITES;
+	header.size = *size;
+	header.sprites_offset = sprites_offset;
+	header.animations_offset = animations_offset;
+	header.formation_offset = formation_offset;
+
+	AssetPackSprite* records = (AssetPackSprite*)(data + sprites_offset);
+	for(size_t i = 0; i < NUM_ASSET_SPRITES; ++i)
+	{
+		const PackerSprite& sprite = packer.sprites[i];
+		size_t num_rows = sprite.frames * sprite.height;
+		records[i].width = sprite.width;
+		records[i].height = sprite.height;
+		records[i].frames = sprite.frames;
+		records[i].rows_offset = rows_offset;
+		memcpy(data + rows_offset, sprite.rows, num_rows * sizeof(uint32_t));
+		rows_offset += num_rows * sizeof(uint32_t);
+	}
+	memcpy(data + animations_offset, packer.animations, sizeof(packer.animations));
+	memcpy(data + formation_offset, &packer.formation, sizeof(AssetFormation));
+	return data;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc != 3)
+	{
+		fprintf(stderr, "Usage: %s SOURCE PACK\n", argv[0]);
+		return 1;
+	}
+
+	FILE* source = fopen(argv[1], "r");
+	if(!source)
+	{
+		fprintf(stderr, "Cannot open %s.\n", argv[1]);
+		return 1;
+	}
+	Packer packer;
+	memset(&packer, 0, sizeof(packer));
+	packer.path = argv[1];
+	packer_read(&packer, source);
+	fclose(source);
+
+	size_t size;
+	uint8_t* data = packer_build(packer, &size);
+	char temporary_path[4096];
+	snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", argv[2]);
+	FILE* file = fopen(temporary_path, "wb");
+	if(!file || fwrite(data, 1, size, file) != size || fclose(file) != 0)
+	{
+		fprintf(stderr, "Cannot write %s.\n", temporary_path);
+		return 1;
+	}
+
+	AssetPack pack;
+	if(!asset_pack_open(&pack, temporary_path))
+	{
+		fprintf(stderr, "The pack written does not load: %s.\n", pack.error);
+		remove(temporary_path);
+		return 1;
+	}
+	asset_pack_close(&pack);
+	if(rename(temporary_path, argv[2]) != 0)
+	{
+		fprintf(stderr, "Cannot replace %s.\n", argv[2]);
+		remove(temporary_path);
+		return 1;
+	}
+
+	printf("Packed %s into %s, %lu bytes\n", argv[1], argv[2], size);
+	for(size_t i = 0; i < NUM_ASSET_SPRITES; ++i) delete[] packer.sprites[i].rows;
+	delete[] data;
+	return 0;
+}
@@ -0,0 +1,72 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Set in TripleBuffer::middle while it holds a value the reader has not taken
+#define TRIPLE_BUFFER_FRESH 4
+
+// Hands the latest of a stream of values from one writer thread to one
+// reader thread without locks. The writer fills its back slot then swaps it
+// with the middle one, the reader swaps its front slot with the middle one
+// when a fresh value is there. Neither side ever waits for the other: the
+// writer may publish any number of values while the reader holds its front
+// slot, and the reader always gets the most recent one
+template<typename T>
+struct TripleBuffer
+{
+	T slots[3];
+	// Slot index, with TRIPLE_BUFFER_FRESH when it was published since the
+	// reader last took it
+	alignas(64) std::atomic<uint8_t> middle;
+	// Slot the writer fills
+	alignas(64) uint8_t back;
+	// Slot the reader uses
+	alignas(64) uint8_t front;
+};
+
+// The slots themselves are initialized by the caller
+template<typename T>
+void triple_buffer_init(TripleBuffer<T>* buffer)
+{
+	buffer->back = 0;
+	buffer->middle.store(1, std::memory_order_relaxed);
+	buffer->front = 2;
+}
+
+// Writer side: the slot to fill next
+template<typename T>
+T* triple_buffer_back(TripleBuffer<T>* buffer)
+{
+	return &buffer->slots[buffer->back];
+}
+
+// Writer side: make the back slot the latest value, and get a new back slot
+template<typename T>
+void triple_buffer_publish(TripleBuffer<T>* buffer)
+{
+	uint8_t previous = buffer->middle.exchange(buffer->back | TRIPLE_BUFFER_FRESH, std::memory_order_acq_rel);
+	buffer->back = previous & ~TRIPLE_BUFFER_FRESH;
+}
+
+// Reader side: take the latest value if one was published since the last
+// call. Returns false if the front slot already holds the latest value
+template<typename T>
+bool triple_buffer_acquire(TripleBuffer<T>* buffer)
+{
+	if(!(buffer->middle.load(std::memory_order_relaxed) & TRIPLE_BUFFER_FRESH)) return false;
+	uint8_t previous = buffer->middle.exchange(buffer->front, std::memory_order_acq_rel);
+	buffer->front = previous & ~TRIPLE_BUFFER_FRESH;
+	return true;
+}
+
+// Reader side: the value taken by the last acquire
+template<typename T>
+const T* triple_buffer_front(const TripleBuffer<T>* buffer)
+{
+	return &buffer->slots[buffer->front];
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include <cstdio>
+#include "upload.h"
+#include "timing.h"
+
+bool texture_upload_init(TextureUpload* upload, Arena* arena, UploadMode mode, PixelFormat format,
+		GLuint texture, size_t width, size_t height, bool read_back)
+{
+	upload->mode = UPLOAD_SYNC;
+	upload->texture = texture;
+	upload->width = width;
+	upload->height = height;
+	upload->format = format;
+	upload->pixel_size = pixel_format_size(format);
+	upload->pixels = arena_alloc_array<uint8_t>(arena, width * height * upload->pixel_size);
+	upload->pbo = 0;
+	upload->mapped = NULL;
+	for(size_t i = 0; i < UPLOAD_RING_SIZE; ++i)
+	{
+		upload->fences[i] = 0;
+	}
+	upload->slot = 0;
+	upload->stall_ns = 0;
+	upload->total_stall_ns = 0;
+	upload->max_stall_ns = 0;
+	upload->total_bytes = 0;
+	upload->frames = 0;
+
+	if(mode == UPLOAD_SYNC) return true;
+
+	if(!GLEW_VERSION_4_4 && !GLEW_ARB_buffer_storage)
+	{
+		return false;
+	}
+
+	size_t frame_bytes = width * height * upload->pixel_size;
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	// Reading a write-only mapping is undefined, and slow where it is
+	// write-combined memory. Client storage asks for cached memory instead
+	if(read_back) flags |= GL_MAP_READ_BIT;
+	glGenBuffers(1, &upload->pbo);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload->pbo);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, UPLOAD_RING_SIZE * frame_bytes, NULL,
+			read_back? flags | GL_CLIENT_STORAGE_BIT: flags);
+	upload->mapped = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, UPLOAD_RING_SIZE * frame_bytes, flags);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if(!upload->mapped)
+	{
+		glDeleteBuffers(1, &upload->pbo);
+		upload->pbo = 0;
+		return false;
+	}
+
+	upload->mode = UPLOAD_PBO;
+	// The first frame goes to slot 0
+	upload->slot = UPLOAD_RING_SIZE - 1;
+	return true;
+}
+
+void texture_upload_free(TextureUpload* upload)
+{
+	for(size_t i = 0; i < UPLOAD_RING_SIZE; ++i)
+	{
+		if(upload->fences[i]) glDeleteSync(upload->fences[i]);
+	}
+	if(upload->pbo)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload->pbo);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &upload->pbo);
+	}
+}
+
+// Point the buffer at the pixels of the frame
+static void upload_bind_buffer(const TextureUpload& upload, Buffer* buffer, uint8_t* pixels)
+{
+	buffer->format = upload.format;
+	buffer->data = upload.format == PIXEL_RGBA? (uint32_t*)pixels: NULL;
+	buffer->indices = upload.format == PIXEL_INDEXED? pixels: NULL;
+}
+
+void texture_upload_begin(TextureUpload* upload, Buffer* buffer)
+{
+	if(upload->mode == UPLOAD_SYNC)
+	{
+		upload_bind_buffer(*upload, buffer, upload->pixels);
+		return;
+	}
+
+	upload->slot = (upload->slot + 1) % UPLOAD_RING_SIZE;
+	upload->stall_ns = 0;
+
+	// Wait until the GPU is done reading the frame previously stored in the slot
+	GLsync fence = upload->fences[upload->slot];
+	if(fence)
+	{
+		uint64_t start = time_ns();
+		GLenum status;
+		do
+		{
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		}
+		while(status == GL_TIMEOUT_EXPIRED);
+		upload->stall_ns = time_ns() - start;
+		glDeleteSync(fence);
+		upload->fences[upload->slot] = 0;
+	}
+
+	upload_bind_buffer(*upload, buffer, upload->mapped + upload->slot * upload->width * upload->height * upload->pixel_size);
+}
+
+void texture_upload_end(TextureUpload* upload, const Buffer& buffer, const Rect* rects, size_t num_rects)
+{
+	glBindTexture(GL_TEXTURE_2D, upload->texture);
+	GLenum format = upload->format == PIXEL_INDEXED? GL_RED: GL_RGBA;
+	GLenum type = upload->format == PIXEL_INDEXED? GL_UNSIGNED_BYTE: GL_UNSIGNED_INT_8_8_8_8;
+	const void* pixels = upload->format == PIXEL_INDEXED? (const void*)buffer.indices: (const void*)buffer.data;
+	// Rows of indices are not padded to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	if(upload->mode == UPLOAD_SYNC)
+	{
+		uint64_t start = time_ns();
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, buffer.width);
+		for(size_t i = 0; i < num_rects; ++i)
+		{
+			const Rect& rect = rects[i];
+			glPixelStorei(GL_UNPACK_SKIP_PIXELS, rect.x0);
+			glPixelStorei(GL_UNPACK_SKIP_ROWS, rect.y0);
+			glTexSubImage2D(
+					GL_TEXTURE_2D, 0, rect.x0, rect.y0,
+					rect.x1 - rect.x0, rect.y1 - rect.y0,
+					format, type, pixels
+					);
+			upload->total_bytes += (rect.x1 - rect.x0) * (rect.y1 - rect.y0) * upload->pixel_size;
+		}
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+		upload->stall_ns = time_ns() - start;
+	}
+	else
+	{
+		// With a pixel unpack buffer bound the data pointer is an offset into it
+		size_t offset = upload->slot * upload->width * upload->height * upload->pixel_size;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload->pbo);
+		glTexSubImage2D(
+				GL_TEXTURE_2D, 0, 0, 0,
+				upload->width, upload->height,
+				format, type, (const void*)offset
+				);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		upload->fences[upload->slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		upload->total_bytes += upload->width * upload->height * upload->pixel_size;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	++upload->frames;
+	upload->total_stall_ns += upload->stall_ns;
+	if(upload->stall_ns > upload->max_stall_ns) upload->max_stall_ns = upload->stall_ns;
+}
+
+void texture_upload_print_stats(const TextureUpload& upload)
+{
+	if(!upload.frames) return;
+	printf("Upload (%s, %s): %.0f bytes/frame, stall %.1f us/frame on average, %.1f us max\n",
+			upload.mode == UPLOAD_PBO? "pbo": "sync", upload.format == PIXEL_INDEXED? "indexed": "rgba",
+			(double)upload.total_bytes / upload.frames,
+			upload.total_stall_ns / 1e3 / upload.frames, upload.max_stall_ns / 1e3);
+}
@@ -0,0 +1,65 @@
+#ifndef UPLOAD_H
+#define UPLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <GL/glew.h>
+#include "arena.h"
+#include "buffer.h"
+
+// Number of pixel buffer objects the frames cycle through
+#define UPLOAD_RING_SIZE 3
+
+enum UploadMode
+{
+	// glTexSubImage2D straight from the client-side buffer
+	UPLOAD_SYNC,
+	// Rasterize into a persistently mapped ring of pixel buffer objects,
+	// so the transfer of one frame overlaps the rasterization of the next
+	UPLOAD_PBO
+};
+
+// Streams the buffer into the texture every frame
+struct TextureUpload
+{
+	UploadMode mode;
+	GLuint texture;
+	size_t width, height;
+	// RGBA pixels go to a GL_RGBA8 texture, indices to a GL_R8 one
+	PixelFormat format;
+	size_t pixel_size;
+	// Client-side pixels for UPLOAD_SYNC, from the arena given to texture_upload_init
+	uint8_t* pixels;
+	// Ring of UPLOAD_RING_SIZE frames in one persistently mapped buffer for UPLOAD_PBO
+	GLuint pbo;
+	uint8_t* mapped;
+	GLsync fences[UPLOAD_RING_SIZE];
+	// Ring slot of the current frame, always 0 for UPLOAD_SYNC
+	size_t slot;
+	// Time the CPU was blocked by the upload: waiting for a free ring slot
+	// for UPLOAD_PBO, inside glTexSubImage2D for UPLOAD_SYNC
+	uint64_t stall_ns;
+	uint64_t total_stall_ns;
+	uint64_t max_stall_ns;
+	// Bytes sent to the texture
+	size_t total_bytes;
+	size_t frames;
+};
+
+// Falls back to UPLOAD_SYNC, and returns false, if the context cannot map
+// buffers persistently. With read_back the frames are also read from the
+// buffer once rasterized, by a capture, so the ring is mapped readable too
+bool texture_upload_init(TextureUpload* upload, Arena* arena, UploadMode mode, PixelFormat format,
+		GLuint texture, size_t width, size_t height, bool read_back);
+void texture_upload_free(TextureUpload* upload);
+
+// Point the buffer to the memory the next frame is rasterized into
+void texture_upload_begin(TextureUpload* upload, Buffer* buffer);
+
+// Send the rasterized frame to the texture. Only the rectangles are copied
+// for UPLOAD_SYNC, a ring slot always holds a complete frame for UPLOAD_PBO
+void texture_upload_end(TextureUpload* upload, const Buffer& buffer, const Rect* rects, size_t num_rects);
+
+void texture_upload_print_stats(const TextureUpload& upload);
+
+#endif